@@ -0,0 +1,131 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+/* Measures how fast spec_file reads generated spec files.
+ *
+ * usage: spec-bench [NUMBER_OF_REGISTERS [RUNS]]
+ *
+ * Writes a spec file with NUMBER_OF_REGISTERS 32-bit registers (200000 by
+ * default, i.e. about 34 MB in 2.3 million lines) to /tmp, reads it RUNS
+ * times (5 by default) and prints the best throughput.  Then does the same
+ * for the spec cache of that file. */
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include <spec-file.hh>
+
+using namespace std;
+
+
+/*** help functions ****************************************************/
+
+/* writes the spec file and returns its number of lines */
+static size_t generate(FILE *f, unsigned number_of_registers){
+    mt19937 random(1);
+    size_t lines = 0;
+    for(unsigned i = 0; i < number_of_registers; i++){
+        fprintf(f, "# register %u\n0 reg_%u\n", i, i);
+        for(unsigned width = 0; width < 32; ){
+            unsigned w = min<unsigned>(1 + random() % 8, 32 - width);
+            if(random() % 5){
+                fprintf(f, "%u field_%u # bits %u..\n", w, width, width);
+            }else{
+                fprintf(f, "%u\n", w);
+            }//else
+            width += w;
+            lines++;
+        }//for
+        fprintf(f, "0\n\n");
+        lines += 4;
+    }//for
+    return lines;
+}//generate
+
+/* returns the best time in seconds out of runs reads of filename */
+static double best_time(const char *filename, bool use_image, unsigned runs){
+    double response = 1e9;
+    for(unsigned i = 0; i < runs; i++){
+        auto start = chrono::steady_clock::now();
+        spec_file RI(filename, use_image);
+        chrono::duration<double> d = chrono::steady_clock::now() - start;
+        if(! RI.number_of_registers()){
+            throw(reg_info_exception("no registers read"));
+        }//if
+        response = min(response, d.count());
+    }//for
+    return response;
+}//best_time
+
+
+/*** main **************************************************************/
+
+int main(int argc, char *argv[]){
+    unsigned number_of_registers = argc > 1 ? atoi(argv[1]) : 200000;
+    unsigned runs = argc > 2 ? atoi(argv[2]) : 5;
+    if(! number_of_registers || ! runs){
+        cerr << "usage: spec-bench [NUMBER_OF_REGISTERS [RUNS]]" << endl;
+        return 2;
+    }//if
+
+    char filename[] = "/tmp/spec-bench-XXXXXX";
+    int fd = mkstemp(filename);
+    if(fd < 0){
+        cerr << "spec-bench: cannot create temporary file" << endl;
+        return 2;
+    }//if
+    FILE *f = fdopen(fd, "w");
+    size_t lines = generate(f, number_of_registers);
+    double megabytes = ftell(f) / 1e6;
+    fclose(f);
+    string image_name = string(filename) + spec_file::IMAGE_SUFFIX;
+
+    int response = 0;
+    try{
+        double t = best_time(filename, false, runs);
+        printf("spec file:  %.1f MB, %zu lines, %u registers\n",
+               megabytes, lines, number_of_registers);
+        printf("parse:      %8.2f ms  %8.1f MB/s  %8.2f Mlines/s\n",
+               t * 1e3, megabytes / t, lines / t / 1e6);
+
+        spec_file(filename, false).save_image();
+        t = best_time(filename, true, runs);
+        printf("cache load: %8.2f ms\n", t * 1e3);
+    }//try
+    catch(exception &e){
+        cerr << "spec-bench: " << e.what() << endl;
+        response = 1;
+    }//catch
+
+    unlink(image_name.c_str());
+    unlink(filename);
+    return response;
+}//main
+
+/* aczutro ************************************************************* end */
@@ -0,0 +1,166 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#ifndef batch_decoder_hh
+#define batch_decoder_hh batch_decoder_hh
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <exceptions.hh>
+#include <core-state.hh>
+#include <reg-info.hh>
+#include <reserved-check.hh>
+
+
+/*** class declaration *******************************************************/
+
+/* Decodes a stream of register values (one hexadecimal value per line) into
+ * the register's fields, without any of the interactive decoration of
+ * core::print_register.  Each output line reads
+ *     VALUE FIELD=HEX FIELD=HEX ...
+ * with VALUE zero-padded to the register's width, and HEX followed by
+ * (NAME) if the spec names that value of the field.
+ * In diff mode, each value is compared with the one on the previous valid
+ * line instead, and only values that differ give an output line
+ *     LINE: OLD -> NEW FIELD=OLD->NEW ...
+ * listing the fields that differ.  Diffs are made in one thread, as line
+ * numbers are needed in the output.
+ * Alternatively, a batch_decoder checks the values against the reserved
+ * bits of registers (see reserved_check) instead of decoding them, and
+ * reports the values with reserved bits set as erroneous lines.
+ * A batch_decoder keeps all its scratch space to itself, so copies of one
+ * decoder can work on different parts of the input concurrently. */
+
+class batch_decoder{
+
+private:
+    struct field{
+        std::string prefix; // " NAME="
+        field_extractor F;
+    };
+
+    std::vector<field> fields;
+    uint16_t number_of_bits;
+    const spec_file *file; // holding the value names of the fields
+
+    bool diff;
+    bool have_previous;
+    uint64_t previous[core_state::MAX_LIMBS]; // value of last valid line
+    size_t line_number; // counting all lines passed to decode_lines
+
+    /* if not NULL, values are checked against it instead of decoded */
+    const reserved_check *check;
+    std::vector<uint32_t> violations;
+    std::vector<uint64_t> hits;
+    exceptions::signal failure; // of the last failed check
+    std::string detail; // registers and bits, or width, of that check
+
+    uint64_t value[core_state::MAX_LIMBS];
+    uint64_t tmp_limbs[core_state::MAX_LIMBS];
+
+    struct line_error{
+        size_t line; // counting from 0 at the start of a decode_lines call
+        exceptions::signal e;
+        std::string detail; // appended to the error message if not empty
+    };
+
+    std::string out; // output buffer
+    FILE *stream;
+    bool autoflush;  // write out to stream whenever a block is full
+
+    std::vector<line_error> errors;
+
+    /* Reads the value on the line of n characters at a into value, and
+     * sets digits to the number of hexadecimal digits it is written with.
+     * Returns false if the line is blank; throws BAD_HEX_STRING or
+     * BAD_VALUE_FOR_REG_WIDTH if it is not a valid value. */
+    bool read_value(const char *a, size_t n, size_t &digits);
+
+    /* Checks value, which is written with digits hexadecimal digits.
+     * Returns false and sets failure and detail if reserved bits are set
+     * (RESERVED_BITS_SET) or no register is as wide as value
+     * (NO_REGISTER_OF_WIDTH); throws BAD_VALUE_FOR_REG_WIDTH if value is
+     * too wide. */
+    bool check_value(size_t digits);
+
+    /* appends field F of a in hex to out, followed by (NAME) if the spec
+     * names that value */
+    void append_field(const field_extractor &F, const uint64_t *a);
+
+    /* writes the fields in which value differs from previous, if any */
+    void diff_value();
+
+    /* Decodes every line in begin..end in place and records erroneous
+     * lines in errors.  Returns the number of lines. */
+    size_t decode_lines(const char *begin, const char *end);
+
+    /* Prints the recorded errors on stderr, prefixed with name and line
+     * number (counting from first_line), and forgets them.
+     * Returns the number of errors. */
+    size_t report(const char *name, size_t first_line);
+
+    /* Decodes begin..end with jobs copies of this decoder, each working on
+     * a different chunk, and writes the output in input order.
+     * Returns the number of erroneous lines. */
+    size_t run_parallel(const char *begin, const char *end,
+                        const char *name, unsigned jobs);
+
+public:
+    /* Decodes, or diffs if diff, values of register regname.  Throws
+     * UNKNOWN_REG_DEF if regname is not defined in RI, and
+     * UNSUPPORTED_WIDTH if the register is wider than the accumulator can
+     * ever be. */
+    batch_decoder(reg_info *RI, const std::string &regname, bool diff=false,
+                  FILE *output=stdout);
+
+    /* Checks values against C.  Values are number_of_bits wide, or, if
+     * number_of_bits is 0, as wide as the hexadecimal digits they are
+     * written with. */
+    batch_decoder(const reserved_check *C, uint16_t number_of_bits,
+                  FILE *output=stdout);
+
+    ~batch_decoder();
+
+    /* Decodes the line of n characters at a (without '\n').  Empty lines
+     * are skipped.  Throws BAD_HEX_STRING or BAD_VALUE_FOR_REG_WIDTH if the
+     * line is not a valid value for the register, and RESERVED_BITS_SET or
+     * NO_REGISTER_OF_WIDTH if checking and the check fails. */
+    void decode(const char *a, size_t n);
+
+    /* Decodes everything that can be read from the file descriptor fd.
+     * Regular files are memory-mapped and decoded without copying, on up
+     * to jobs threads; pipes and terminals are read in large blocks.
+     * Errors are reported on stderr, prefixed with name and line number,
+     * and don't stop decoding.
+     * Returns the number of erroneous lines; throws reg_info_exception if
+     * fd cannot be read. */
+    size_t run(int fd, const char *name, unsigned jobs=1);
+
+    /* writes buffered output to the output stream */
+    void flush();
+};
+
+#endif
+
+/* aczutro ************************************************************* end */
@@ -26,53 +26,90 @@
 #include <stdint.h>
 #include <string>
 
+#include <limbs.hh>
+
 
 /*** class to hold snapshot of accumulator status ****************************/
 
 class core_state{
 
+public:
+    static const uint16_t MAX_NUMBER_OF_BITS = UINT8_MAX + 1;
+    static const uint8_t MAX_WIDTH = MAX_NUMBER_OF_BITS / 4;
+    static const uint8_t MAX_LIMBS = MAX_NUMBER_OF_BITS / 64;
+
+    /* largest number of words written by delta() */
+    static const uint8_t MAX_DELTA_WORDS = MAX_LIMBS + 1;
+
 private:
-    std::string __hex;
+    uint64_t __limbs[MAX_LIMBS]; // value, least significant limb first
     uint8_t __width;
+    uint8_t __digits;            // current number of hex digits
     bool __perm_hilite;
     uint8_t __perm_hilite_min;
     uint8_t __perm_hilite_max;
-    size_t index;
 
-public:
-    static const uint16_t MAX_NUMBER_OF_BITS = UINT8_MAX + 1;
-    static const uint8_t MAX_WIDTH = MAX_NUMBER_OF_BITS / 4;
+    /* everything but the value, packed into one word */
+    uint64_t packed_data() const;
+    void unpack_data(uint64_t a);
 
+public:
     bool show_indices;
 
     inline core_state(){
-        __hex.reserve(MAX_WIDTH);
-        __hex             = "0";
+        for(uint8_t i = 0; i < MAX_LIMBS; i++){
+            __limbs[i] = 0;
+        }//for
         __width           = 0;         // 0 is variable number of hex digits
+        __digits          = 1;
         show_indices      = true;
         __perm_hilite     = false;
         __perm_hilite_min = UINT8_MAX; // invalid on purpose, as perm_hilite is false
         __perm_hilite_max = UINT8_MAX; // invalid on purpose, as perm_hilite is false
     }
 
-    inline const std::string &hex()           {return __hex;}
+    inline const uint64_t    *limbs()         {return __limbs;}
     inline uint8_t           width()          {return __width;}
-    inline uint16_t          number_of_bits() {return __hex.length() * 4;}
+    inline uint8_t           digits()         {return __digits;}
+    inline uint16_t          number_of_bits() {return __digits * 4;}
     inline bool              perm_hilite()    {return __perm_hilite;}
     inline uint8_t           perm_hilite_min(){return __perm_hilite_min;}
     inline uint8_t           perm_hilite_max(){return __perm_hilite_max;}
 
-    /* MAKES NO SECURITY TESTS, i.e. a MUST be hexadecimal and not wider than
-     * WIDTH if width is fixed.  If it is wider, it will be truncated
-     * (silently). */
-    core_state &operator=(const std::string &a);
+    /* MAKES NO SECURITY TESTS, i.e. i MUST be < digits().
+     * Nibble 0 is the least significant one. */
+    inline uint8_t nibble(uint8_t i){
+        return (__limbs[i / 16] >> (i % 16 * 4)) & 0xf;
+    }//nibble
+
+    /* renders the value as a string of digits() hexadecimal digits */
+    std::string hex();
+
+    /* Sets the value to the MAX_LIMBS limbs at a.  If a is wider than
+     * WIDTH if width is fixed, it will be truncated (silently). */
+    core_state &set_value(const uint64_t *a);
+
+    /* MAKES NO SECURITY TESTS, i.e. lo MUST be <= hi, and hi MUST be
+     * < number_of_bits() */
+    inline core_state &flip_range(uint16_t lo, uint16_t hi){
+        limbs::xor_range(__limbs, lo, hi);
+        return *this;
+    }//flip_range
 
-    /* MAKES NO SECURITY TESTS, i.e. i MUST be < width(), and a MUST be
-     * a hexadecimal digit. */
-    inline core_state &replace_nibble(uint8_t i, char a){
-        __hex[i] = a;
+    /* Overwrites bits lo..hi with the MAX_LIMBS limbs at a.
+     * MAKES NO SECURITY TESTS, i.e. lo MUST be <= hi, and hi MUST be
+     * < number_of_bits(); bits of a that don't fit are cut off (silently). */
+    inline core_state &deposit(uint16_t lo, uint16_t hi, const uint64_t *a){
+        limbs::deposit(__limbs, lo, hi, a, MAX_LIMBS);
         return *this;
-    }//replace_nibble
+    }//deposit
+
+    /* Copies bits lo..hi into the MAX_LIMBS limbs at a, such that bit lo
+     * becomes bit 0 of a.
+     * MAKES NO SECURITY TESTS, i.e. lo MUST be <= hi. */
+    inline void extract(uint16_t lo, uint16_t hi, uint64_t *a){
+        limbs::extract(__limbs, MAX_LIMBS, lo, hi, a);
+    }//extract
 
     /* MAKES NO SECURITY TESTS, i.e. a MUST be <= MAX_WIDTH;
      * also, if a is too short, the current value is truncated (silently) */
@@ -90,8 +127,18 @@ public:
         return *this;
     }//reset_perm_hilite
 
+    /* Writes the parts of this state that differ from a to d, XORed with
+     * their counterpart in a, and returns which parts they are: bit i stands
+     * for limb i, bit MAX_LIMBS for everything but the value.  Writes at
+     * most MAX_DELTA_WORDS words, one per differing part, in that order. */
+    uint8_t delta(const core_state &a, uint64_t *d) const;
+
+    /* Applies a difference written by delta(), which turns either state
+     * compared into the other one. */
+    core_state &apply_delta(uint8_t parts, const uint64_t *d);
+
     inline void print(){
-        printf("%s  wd(%d)", __hex.c_str(), __width);
+        printf("%s  wd(%d)", hex().c_str(), __width);
         if(show_indices){
             printf("  idx");
         }//if
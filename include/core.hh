@@ -23,7 +23,7 @@
 #ifndef core_hh
 #define core_hh core_hh
 
-#include <history-index.hh>
+#include <history.hh>
 #include <core-state.hh>
 #include <reg-info.hh>
 
@@ -34,42 +34,33 @@ class core{
 
 private:
     core_state    C; // current state (accumulator)
-    core_state    *H; // history
-
-    history_index bottom;
-    history_index top;
-    history_index last_push;
-
-    bool          no_redo;
+    history       H;
 
     /* temporal variables ********************************************/
 
-    char        *tmp_hex;
-    uintmax_t   tmp_dec;
+    char        *tmp_text;
+    uint64_t    tmp_limbs[core_state::MAX_LIMBS];
     uint8_t     tmp_byte1, tmp_byte2;
-    std::string tmp_string;
 
     std::string line1;
     std::string line2;
     std::string line3;
     std::string line4;
     std::string line5;
+    std::string line6;
 
     std::string hilited_hex;
     std::string hilited_string;
-    uintmax_t   hilited_dec;
 
     /* history *******************************************************/
 
-    void init_history();
-
     void history_push();
 
     void history_pop();
 
     void history_unpop();
 
-    void __print_history();
+    void history_switch(bool forward);
 
 public:
     void print_history();
@@ -102,12 +93,24 @@ public:
 
     /* undo **********************************************************/
 
-    void resize_history(uint8_t a);
+    /* sets the history capacity to a undo steps and its memory budget to
+     * kib KiB */
+    void resize_history(uintmax_t a, uintmax_t kib);
 
-    inline uint8_t get_history_size(){
-        return history_index::history_size() - 2;
+    inline size_t get_history_size(){
+        return H.capacity() - 1;
     }//get_history_size
 
+    /* in KiB */
+    inline size_t get_history_budget(){
+        return H.budget() / 1024;
+    }//get_history_budget
+
+    /* in KiB, rounded up */
+    inline size_t get_history_memory(){
+        return (H.memory() + 1023) / 1024;
+    }//get_history_memory
+
     inline core &undo(){
         history_pop();
         return *this;
@@ -118,13 +121,20 @@ public:
         return *this;
     }//redo
 
+    /* switches to the next (or previous) branch made at the step before
+     * the current one */
+    inline core &switch_branch(bool forward=true){
+        history_switch(forward);
+        return *this;
+    }//switch_branch
+
     /* width *********************************************************/
 
     inline uint8_t get_width(){
         return(C.width());
     }//get_width
 
-    core &set_width(uint8_t a);
+    core &set_width(uint16_t a);
 
     /* bit flipping **************************************************/
 
@@ -151,6 +161,17 @@ public:
     void print_registers(reg_info *RI);
 
     void print_register(reg_info *RI, const std::string &regname);
+
+    /* prints the fields of register regname that differ between the
+     * accumulator and the hexadecimal value a */
+    void print_diff(reg_info *RI, const std::string &regname,
+                    const std::string &a);
+
+    void print_matches(reg_info *RI, const std::string &pattern);
+
+    /* checks the accumulator against the reserved bits of register regname,
+     * or of all registers of its width if regname is empty */
+    void check_reserved(reg_info *RI, const std::string &regname);
 };
 
 #endif
@@ -38,7 +38,7 @@ namespace exceptions{
         /* g */ "highlighting limits are out of range",
         /* h */ "value too large for current accumulator width",
         /* i */ "value too large for width of highlighted bit field",
-        /* j */ "current version supports only up to width 16 (64 bit)",
+        /* j */ "current version supports only up to width 64 (256 bit)",
         /* k */ "inversion limits are out of range",
         /* l */ "no permanently highlighted bits",
         /* m */ "no more undo history",
@@ -49,7 +49,12 @@ namespace exceptions{
         /* r */ "unknown register name",
         /* s */ "requested register's width mismatches current accumulator width",
         /* t */ "",
-        /* u */ ""
+        /* u */ "",
+        /* v */ "value too large for register width",
+        /* w */ "reserved bits are set",
+        /* x */ "history memory budget too small",
+        /* y */ "no other branch at this step",
+        /* z */ "no register of width"
     };
 
     enum signal{
@@ -73,7 +78,12 @@ namespace exceptions{
         /* r */ UNKNOWN_REG_DEF,
         /* s */ INCOMP_REG_WIDTH,
         /* t */ EMPTY_COMMAND,
-        /* u */ EOF_COMMAND
+        /* u */ EOF_COMMAND,
+        /* v */ BAD_VALUE_FOR_REG_WIDTH,
+        /* w */ RESERVED_BITS_SET,
+        /* x */ HISTORY_BUDGET_SMALL,
+        /* y */ NO_OTHER_BRANCH,
+        /* z */ NO_REGISTER_OF_WIDTH
     };
 
 }//exceptions
@@ -0,0 +1,176 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#ifndef history_hh
+#define history_hh history_hh
+
+#include <stdint.h>
+#include <vector>
+
+#include <core-state.hh>
+
+
+/*** class declaration *******************************************************/
+
+/* Undo tree of the accumulator.  Every entry but the oldest (the root) has
+ * a parent, the entry it was made from, and is kept as its difference to
+ * that parent (see core_state::delta), which for the usual edit of a few
+ * bits is one node plus one word; only the current entry is kept as a
+ * whole.  Differences are symmetric, so undo, redo and switching to a
+ * sibling branch apply one or two differences to the current entry.
+ * Making an entry after an undo adds a branch to the tree instead of
+ * dropping the entries that could be redone.  Every entry remembers its
+ * active child, the branch that was made or visited last from it; redo
+ * follows that branch.
+ * The tree is bounded both by a number of entries and by a memory budget;
+ * when either is exceeded, the oldest entries are forgotten, together with
+ * the branches starting at them.  Push, undo, redo and switching branches
+ * take constant time (push amortised), no matter how many entries there
+ * are. */
+
+class history{
+
+public:
+    /* one entry of the active path, see entries() */
+    struct entry{
+        core_state state;
+        uint32_t branch;   // counting from 1, in the order made
+        uint32_t branches; // number of siblings including this entry
+    };
+
+private:
+    static const uint32_t NONE = UINT32_MAX;
+
+    struct node{
+        uint32_t parent;
+        uint32_t first_child;
+        uint32_t next, prev;  // siblings, circular, in the order made
+        uint32_t active;      // child redo goes to
+        uint32_t offset;      // of the difference in words
+        uint8_t parts;        // of the difference
+    };
+
+    core_state current;    // state of entry cur
+
+    std::vector<node> nodes;
+    std::vector<uint32_t> free_nodes;
+    std::vector<uint64_t> words;
+    /* free_words[n] lists free runs of n words */
+    std::vector<uint32_t> free_words[core_state::MAX_DELTA_WORDS + 1];
+
+    uint32_t root;
+    uint32_t cur;
+    size_t live_nodes;
+    size_t live_words;
+
+    size_t max_entries;
+    size_t max_bytes;
+
+    /* makes a node for the difference in parts and d, without links */
+    uint32_t new_node(uint8_t parts, const uint64_t *d);
+
+    /* frees the difference of node i, leaving it empty */
+    void free_difference(uint32_t i);
+
+    /* frees node i and all entries made from it */
+    void free_subtree(uint32_t i);
+
+    /* removes node i from the children of its parent */
+    void unlink(uint32_t i);
+
+    /* applies the difference of node i to current */
+    void apply(uint32_t i);
+
+    /* forgets the root, which must not be the current entry, and the
+     * branches starting at it that don't lead to the current entry */
+    void drop_root();
+
+    /* Forgets an entry without children made from entry i or from the
+     * entries made from it, one that redo doesn't reach if there is any, and
+     * returns its parent. */
+    uint32_t drop_leaf(uint32_t i);
+
+    /* forgets entries until the history is within its limits: the oldest
+     * first, but never the current one, then the newest */
+    void trim();
+
+public:
+    /* keeps up to capacity entries in up to budget bytes, starting with C */
+    history(size_t capacity, size_t budget, const core_state &C);
+
+    /* Forgets all entries and starts again with C, keeping up to capacity
+     * entries in up to budget bytes. */
+    void reset(size_t capacity, size_t budget, const core_state &C);
+
+    /* Changes the limits, forgetting as many entries as needed to stay
+     * within them (see trim). */
+    void resize(size_t capacity, size_t budget);
+
+    inline size_t size() const{
+        return live_nodes;
+    }//size
+
+    /* maximum number of entries */
+    inline size_t capacity() const{
+        return max_entries;
+    }//capacity
+
+    /* maximum number of bytes for the tree */
+    inline size_t budget() const{
+        return max_bytes;
+    }//budget
+
+    /* number of bytes taken by the tree */
+    inline size_t memory() const{
+        return live_nodes * sizeof(node) + live_words * sizeof(uint64_t);
+    }//memory
+
+    /* Makes C a new entry after the current one, which becomes current.
+     * If the current entry already has entries after it, C starts a new
+     * branch. */
+    void push(const core_state &C);
+
+    /* Sets C to the entry before the current one, which becomes current.
+     * Returns false, without changing C, if there is none. */
+    bool undo(core_state &C);
+
+    /* Sets C to the entry after the current one on the active branch,
+     * which becomes current.  Returns false, without changing C, if there
+     * is none. */
+    bool redo(core_state &C);
+
+    /* Sets C to the next (or, if ! forward, previous) sibling of the
+     * current entry, which becomes current and the active branch of its
+     * parent.  Siblings are in the order made, and the last one is followed
+     * by the first one.  Returns false, without changing C, if the current
+     * entry has no siblings. */
+    bool switch_branch(bool forward, core_state &C);
+
+    /* Reconstructs the active path, from the root through the current
+     * entry to the end of the active branches, into E, and returns the
+     * position of the current entry in E. */
+    size_t entries(std::vector<entry> &E) const;
+};
+
+#endif
+
+/* aczutro ************************************************************* end */
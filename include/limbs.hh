@@ -0,0 +1,105 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#ifndef limbs_hh
+#define limbs_hh limbs_hh
+
+#include <stdint.h>
+
+
+/*** namespace with arithmetic on multi-word numbers *************************/
+
+/* A number is stored as an array of uint64_t "limbs", least significant limb
+ * first.  Bit i of a number is bit (i % 64) of limb (i / 64). */
+
+namespace limbs{
+
+    static const uint8_t LIMB_BITS = 64;
+
+    inline bool bit(const uint64_t *a, uint16_t i){
+        return (a[i / LIMB_BITS] >> (i % LIMB_BITS)) & 1;
+    }//bit
+
+    /* returns index of most significant 1 plus 1, or 0 if a is all-0s */
+    uint16_t significant_bits(const uint64_t *a, uint8_t n);
+
+    /* clears all bits with index >= bits */
+    void truncate(uint64_t *a, uint8_t n, uint16_t bits);
+
+    /* returns the part of mask lo..hi (both inclusive, lo <= hi) that falls
+     * into limb i */
+    inline uint64_t range_mask(uint8_t i, uint16_t lo, uint16_t hi){
+        uint16_t first = i * LIMB_BITS;
+        uint16_t last  = first + LIMB_BITS - 1;
+        if(hi < first || lo > last){
+            return 0;
+        }//if
+        return (~UINT64_C(0) << (lo > first ? lo - first : 0))
+            & (~UINT64_C(0) >> (hi < last ? last - hi : 0));
+    }//range_mask
+
+    /* flips bits lo..hi (both inclusive, lo <= hi) */
+    void xor_range(uint64_t *a, uint16_t lo, uint16_t hi);
+
+    /* returns the 64 bits of a starting at bit i; bits beyond limb n-1
+     * are read as 0s */
+    inline uint64_t window(const uint64_t *a, uint8_t n, uint16_t i){
+        uint8_t  q = i / LIMB_BITS;
+        uint8_t  s = i % LIMB_BITS;
+        uint64_t response = q < n ? a[q] >> s : 0;
+        if(s && q + 1 < n){
+            response |= a[q + 1] << (LIMB_BITS - s);
+        }//if
+        return response;
+    }//window
+
+    /* Overwrites bits lo..hi (both inclusive, lo <= hi) of a with the
+     * least significant bits of the n limbs at b.  Bits of b that don't
+     * fit are cut off (silently). */
+    void deposit(uint64_t *a, uint16_t lo, uint16_t hi,
+                 const uint64_t *b, uint8_t n);
+
+    /* Copies bits lo..hi (both inclusive, lo <= hi) of the n limbs at a
+     * into the n limbs at b, such that bit lo becomes bit 0 of b. */
+    void extract(const uint64_t *a, uint8_t n, uint16_t lo, uint16_t hi,
+                 uint64_t *b);
+
+    /* a = a * m + c; returns the carry out of limb n-1 */
+    uint64_t mul_add(uint64_t *a, uint8_t n, uint64_t m, uint64_t c);
+
+    /* a = a / d; returns a % d.  d MUST NOT be 0. */
+    uint64_t div_mod(uint64_t *a, uint8_t n, uint64_t d);
+
+    inline bool is_zero(const uint64_t *a, uint8_t n){
+        for(uint8_t i = 0; i < n; i++){
+            if(a[i]){
+                return false;
+            }//if
+        }//for
+        return true;
+    }//is_zero
+
+}//limbs
+
+#endif
+
+/* aczutro ************************************************************* end */
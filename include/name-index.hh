@@ -0,0 +1,69 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#ifndef name_index_hh
+#define name_index_hh name_index_hh
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+/*** class declaration *******************************************************/
+
+/* A search index on names, each of which stands for one or more entries
+ * (such as "cause" for register cause, and "addr" for "cause.addr" and
+ * "badaddr.addr").  The distinct names are stored once each, sorted and
+ * NUL-terminated, in one text, and a suffix array on that text finds every
+ * name containing a given string with a binary search. */
+
+class name_index{
+
+private:
+    std::vector<std::string> entries;
+
+    std::vector<char> text;
+    std::vector<uint32_t> starts;   // offset of each name in text
+    std::vector<uint32_t> suffixes; // suffix array on text (without NULs)
+
+    /* the entries of name i are entry_ids[first_entry[i]] up to
+     * entry_ids[first_entry[i + 1] - 1] */
+    std::vector<uint32_t> first_entry;
+    std::vector<uint32_t> entry_ids;
+
+    /* returns the names containing the length characters at a */
+    std::vector<uint32_t> containing(const char *a, size_t length) const;
+
+public:
+    /* entries[i] is found by names[i] */
+    name_index(const std::vector<std::string> &entries,
+               const std::vector<std::string> &names);
+
+    /* Returns the entries whose name matches pattern, sorted.  In a
+     * pattern, '*' stands for any sequence of characters; a pattern without
+     * '*' matches all names that contain it. */
+    std::vector<std::string> find(const std::string &pattern) const;
+};
+
+#endif
+
+/* aczutro ************************************************************* end */
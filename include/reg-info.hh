@@ -23,72 +23,144 @@
 #ifndef reg_info_hh
 #define reg_info_hh reg_info_hh
 
-#include <map>
-#include <queue>
+#include <string>
+#include <vector>
 
+#include <name-index.hh>
+#include <spec-file.hh>
 
-/*** data types **************************************************************/
 
-struct field_data{
-    uint8_t width;
-    std::string name;
-    field_data *next;
+/*** data types **************************************************************/
 
-    field_data(): width(0), name(""), next(NULL){}
+/* A register found by reg_info::find: its layout, and the spec file whose
+ * name and field tables the layout refers to.  Both are NULL if there is no
+ * such register. */
+struct register_ref{
+    spec_file *file;
+    const register_layout *layout;
 };
 
 
-typedef std::map<std::string, field_data*> register_collection;
-typedef register_collection::const_iterator register_data;
+/*** class declaration *******************************************************/
+
+/* The registers of one or more spec files.  Directories are expanded to the
+ * spec files they contain (recursively, in name order, skipping hidden files
+ * and spec caches), and all files are read concurrently.
+ *
+ * If several files define the same register, the definition read last wins,
+ * just as within one spec file, and a warning names both files.
+ *
+ * While watched, the spec files are read again when they change (see
+ * refresh), using inotify on the directories they are in, so that editors
+ * which replace a file instead of writing to it are noticed as well.
+ *
+ * Register and field names can be searched for (see search); the search
+ * index is built on the first search, since that needs the fields of every
+ * register, and dropped whenever a spec file is read again. */
 
+class reg_info{
 
-class reg_info_exception : public std::exception{
 private:
-    std::string error_message;
+    std::vector<spec_file*> files;
 
-public:
-    reg_info_exception(){
-        error_message = "unknown error cause";
-    }//reg_info_exception
+    /* one entry per register name of all files, in file order; only used if
+     * there is more than one file */
+    struct entry{
+        uint32_t file;
+        uint32_t reg;  // index into the file's register table
+    };
+    std::vector<entry> entries;
+    std::vector<uint32_t> buckets; // entry index + 1, or 0 if empty
 
-    reg_info_exception(const std::string &a){
-        error_message = a;
-    }//reg_info_exception
+    std::vector<std::string> __warnings;
 
-    reg_info_exception(std::initializer_list<const char*> a){
-        error_message = "";
-        for(const char *b : a){
-            error_message.append(b);
-        }//
-    }//reg_info_exception
+    /* inotify instance, or -1 if not watching, and the watch on the
+     * directory of each file */
+    int watch_fd;
+    std::vector<int> watches;
 
-    const char *what() const noexcept{
-        return error_message.c_str();
-    }//what
-};//reg_info_exception;
+    uint16_t __max_number_of_fields;
 
+    /* search index, and the register names in sorted order for complete;
+     * NULL and empty until needed.  The names are copies, as parsing a
+     * register body may move the name tables of the files. */
+    name_index *index;
+    std::vector<std::string> sorted_names;
 
-/*** class declaration *******************************************************/
+    /* returns the name of entry E */
+    inline const char *name(const entry &E) const{
+        return files[E.file]->name(files[E.file]->register_at(E.reg).name);
+    }//name
 
-class reg_info{
+    /* returns the bucket of the entry called a, or the empty bucket it
+     * would go into */
+    uint32_t &bucket(const char *a, size_t length);
 
-private:
-    register_collection *__RD; // register data
-    uint8_t __max_number_of_fields;
-    std::queue<field_data*> memory_to_free;
+    /* builds entries and buckets from the register tables of all files */
+    void merge();
 
-    void delete_RD();
+    /* as find, for register i, 0 <= i < number_of_registers() */
+    register_ref register_at(uint32_t i);
 
 public:
-    reg_info(const char *filename);
+    /* Reads the spec files and directories in paths, using up to jobs
+     * threads; use_image as in spec_file.  Throws reg_info_exception on
+     * errors. */
+    reg_info(const std::vector<std::string> &paths, unsigned jobs=1,
+             bool use_image=true);
 
     ~reg_info();
 
-    const register_collection &RD(){
-        return *__RD;
-    }//RD
+    /* writes the spec cache of every file; see spec_file::save_image */
+    void save_images();
+
+    /* Starts watching the spec files for changes.  Throws
+     * reg_info_exception if they cannot be watched. */
+    void watch();
+
+    void unwatch();
+
+    inline bool watching() const{
+        return watch_fd >= 0;
+    }//watching
+
+    /* Reads the spec files that have changed since the last call again,
+     * without waiting for changes; see spec_file::reload.  Appends a line
+     * per file read again to reports, new warnings to warnings, and a line
+     * per file that could not be read to errors; such files keep their
+     * registers. */
+    void refresh(std::vector<std::string> &reports,
+                 std::vector<std::string> &warnings,
+                 std::vector<std::string> &errors);
+
+    /* Looks up register regname.  The fields of a register are parsed the
+     * first time it is looked up, so this throws reg_info_exception if they
+     * contain errors. */
+    register_ref find(const std::string &regname);
+
+    /* Returns the registers ("REG") and fields ("REG.FIELD") whose names
+     * match pattern, sorted; see name_index::find.  Registers whose fields
+     * contain errors are only found by their own name. */
+    std::vector<std::string> search(const std::string &pattern);
+
+    /* returns the names of the registers starting with prefix, sorted */
+    std::vector<std::string> complete(const std::string &prefix);
+
+    uint32_t number_of_registers() const;
+
+    /* returns the name of register i, 0 <= i < number_of_registers() */
+    const char *register_name(uint32_t i) const;
+
+    /* As find, for register i, but without parsing its fields: only the
+     * name, width and reserved-bit mask of the layout are valid. */
+    register_ref register_header(uint32_t i) const;
+
+    /* diagnostics about registers defined in more than one file */
+    inline const std::vector<std::string> &warnings() const{
+        return __warnings;
+    }//warnings
 
-    uint8_t max_number_of_fields(){
+    uint16_t max_number_of_fields() const{
         return __max_number_of_fields;
     }//max_number_of_fields
 };
@@ -0,0 +1,98 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#ifndef reserved_check_hh
+#define reserved_check_hh reserved_check_hh
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <reg-info.hh>
+
+
+/*** class declaration *******************************************************/
+
+/* Checks values against the reserved-bit masks of the registers of their
+ * width: a value is corrupt for a register if any of the register's
+ * reserved bits is set.
+ *
+ * The masks of all registers of one width are stored limb by limb, i.e. the
+ * first limb of every mask, then the second limb of every mask, and so on,
+ * so that check ANDs a value with all of them in one pass over contiguous
+ * memory, which the compiler turns into vector instructions.
+ * check only reads the object, so one object can be shared by threads, each
+ * with its own scratch space. */
+
+class reserved_check{
+
+private:
+    /* the registers of one width: limb l of the mask of register first + i
+     * is masks[offset + l * count + i] */
+    struct group{
+        uint32_t first;
+        uint32_t count;
+        size_t   offset;
+    };
+    std::vector<group> groups; // indexed by width / 4
+
+    /* per register, sorted by width, then by name */
+    std::vector<std::string> names;
+    std::vector<uint16_t> widths;
+
+    std::vector<uint64_t> masks;
+
+    /* sets up groups and masks for the registers R */
+    void build(std::vector<register_ref> &R);
+
+public:
+    /* checks against every register of RI (those wider than the
+     * accumulator can be are left out) */
+    reserved_check(reg_info *RI);
+
+    /* checks against register regname only; throws UNKNOWN_REG_DEF if
+     * regname is not defined in RI, and UNSUPPORTED_WIDTH if the register is
+     * wider than the accumulator can ever be */
+    reserved_check(reg_info *RI, const std::string &regname);
+
+    /* returns the number of registers of width number_of_bits */
+    uint32_t number_of_registers(uint16_t number_of_bits) const;
+
+    /* Checks value, whose width is number_of_bits, against every register
+     * of that width, and appends the registers whose reserved bits are set
+     * in value to violations.  hits is scratch space. */
+    void check(const uint64_t *value, uint16_t number_of_bits,
+               std::vector<uint32_t> &violations,
+               std::vector<uint64_t> &hits) const;
+
+    inline const std::string &register_name(uint32_t i) const{
+        return names[i];
+    }//register_name
+
+    /* returns the reserved bits of register i that are set in value as a
+     * list of bit ranges, e.g. "[31..21] [3]" */
+    std::string set_bits(const uint64_t *value, uint32_t i) const;
+};
+
+#endif
+
+/* aczutro ************************************************************* end */
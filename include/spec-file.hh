@@ -0,0 +1,352 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#ifndef spec_file_hh
+#define spec_file_hh spec_file_hh
+
+#include <string>
+#include <vector>
+
+#include <limbs.hh>
+
+
+/*** data types **************************************************************/
+
+/* how the names of the values of a field are stored in the value table */
+enum value_kind : uint8_t{
+    NO_VALUE_NAMES,
+    DENSE_VALUE_NAMES,  // one entry per possible value
+    HASHED_VALUE_NAMES  // perfect hash on the named values
+};
+
+
+/* A named field compiled for decoding: bits lo..hi (both inclusive) of the
+ * register.  Fields of up to 64 bits are read with a shift and a mask. */
+struct field_extractor{
+    uint32_t name;        // offset of the name in the name table
+    uint16_t name_length;
+    uint16_t lo;
+    uint16_t hi;
+    uint16_t limb;        // limb containing bit lo
+    uint8_t  shift;       // position of bit lo in that limb
+    uint8_t  value_kind;  // see enum value_kind
+    uint8_t  bucket_bits; // log2 of the seeds of a hashed value table
+    uint8_t  slot_bits;   // log2 of the slots of a hashed value table
+    uint64_t mask;        // hi - lo + 1 least significant bits set (at most 64)
+    uint32_t values;      // offset of the field's value table
+
+    inline uint16_t width() const{
+        return hi - lo + 1;
+    }//width
+
+    /* returns the value of the field in a; field MUST NOT be wider than 64
+     * bits */
+    inline uint64_t value(const uint64_t *a) const{
+        uint64_t response = a[limb] >> shift;
+        if(shift + width() > limbs::LIMB_BITS){
+            response |= a[limb + 1] << (limbs::LIMB_BITS - shift);
+        }//if
+        return response & mask;
+    }//value
+
+    /* Returns true if any bit of the field is set in a, e.g. in the XOR of
+     * two values of the register. */
+    inline bool intersects(const uint64_t *a) const{
+        if(width() <= limbs::LIMB_BITS){
+            return value(a) != 0;
+        }//if
+        for(uint16_t i = limb; i <= hi / limbs::LIMB_BITS; i++){
+            if(a[i] & limbs::range_mask(i, lo, hi)){
+                return true;
+            }//if
+        }//for
+        return false;
+    }//intersects
+
+    /* Copies the field from the n limbs at a into the n limbs at b, such
+     * that bit lo becomes bit 0 of b. */
+    inline void extract(const uint64_t *a, uint8_t n, uint64_t *b) const{
+        if(width() > limbs::LIMB_BITS){
+            limbs::extract(a, n, lo, hi, b);
+            return;
+        }//if
+        b[0] = value(a);
+        for(uint8_t i = 1; i < n; i++){
+            b[i] = 0;
+        }//for
+    }//extract
+};
+
+
+/* A register compiled for decoding: the range of its named fields (most
+ * significant first) in the field table, the column widths
+ * core::print_register lays them out in, and its reserved bits (those of
+ * unnamed fields) as a mask of (width + 63) / 64 limbs in the mask table. */
+struct register_layout{
+    uint32_t name;             // offset of the name in the name table
+    uint32_t first_field;      // index into the field table
+    uint32_t number_of_fields; // named ones only
+    uint64_t body;             // offset of the field lines in the spec file
+    uint32_t body_length;
+    uint32_t first_line;       // line number of the first field line
+    uint32_t reserved;         // offset of the reserved-bit mask
+    bool     parsed;           // if the fields are in the field table
+    uint16_t width;            // of the register, in bits
+    uint16_t name_width;       // longest of register name and field names
+    uint16_t bin_width;        // widest field in bits, at least 3
+    uint16_t hex_width;        // widest field in hex digits, at least 3
+    uint8_t  index_width;      // decimal digits of the highest bit index
+    bool     multi_index;      // if any field is wider than 1 bit
+};
+
+
+class reg_info_exception : public std::exception{
+private:
+    std::string error_message;
+
+public:
+    reg_info_exception(){
+        error_message = "unknown error cause";
+    }//reg_info_exception
+
+    reg_info_exception(const std::string &a){
+        error_message = a;
+    }//reg_info_exception
+
+    reg_info_exception(std::initializer_list<const char*> a){
+        error_message = "";
+        for(const char *b : a){
+            error_message.append(b);
+        }//
+    }//reg_info_exception
+
+    const char *what() const noexcept{
+        return error_message.c_str();
+    }//what
+};//reg_info_exception;
+
+
+/*** class declaration *******************************************************/
+
+/* All registers of a spec file live in three tables: a name table holding
+ * every name once (NUL-terminated), a field table holding the fields of all
+ * registers, and a register table holding one register_layout per register,
+ * which refers to a contiguous range of the field table.  Registers are found
+ * by name through an open-addressing hash index on the register table.
+ *
+ * Names of field values (lines "= VALUE NAME" after a field line) go to a
+ * fourth table.  Narrow fields get an array with one entry per possible
+ * value; wider ones get a perfect hash on their named values, so that
+ * value_name takes constant time either way.
+ *
+ * The reserved-bit masks are computed while locating the register
+ * definitions, so they are available without parsing any register body.
+ *
+ * save_image writes the tables to a spec cache file (the spec file's name
+ * plus IMAGE_SUFFIX).  As long as the spec file doesn't change, later
+ * spec_file objects map the cache file read-only instead of reading the spec
+ * file, so all processes using the same spec share the same pages. */
+
+class spec_file{
+
+private:
+    /* tables built while reading a spec file */
+    std::vector<char> names;
+    std::vector<field_extractor> fields;
+    std::vector<register_layout> registers;
+    std::vector<uint32_t> buckets; // register index + 1, or 0 if empty
+    std::vector<uint32_t> values;  // value tables of all fields
+    std::vector<uint64_t> masks;   // reserved-bit masks of all registers
+
+    /* tables in use: either the vectors above or parts of a mapped cache */
+    const char *__names;
+    const field_extractor *__fields;
+    const register_layout *__registers;
+    const uint32_t *__buckets;
+    const uint32_t *__values;
+    const uint64_t *__masks;
+    uint32_t __number_of_registers;
+    uint32_t __number_of_buckets;
+
+    uint16_t __max_number_of_fields;
+
+    void *image;       // mapped spec cache file, or NULL
+    size_t image_size;
+
+    /* the spec file, kept open for reading register bodies on demand */
+    std::string source_name;
+    int source_fd;
+
+    /* size and modification time of the spec file when it was read */
+    int64_t source_size;
+    int64_t source_mtime[2]; // seconds, nanoseconds
+
+    /* contents of the spec file when it was read, kept for reload */
+    std::string snapshot;
+    bool has_snapshot;
+
+    /* if some register is defined more than once in the spec file */
+    bool redefinitions;
+
+    /* appends the length characters at a to the name table and returns
+     * their offset */
+    uint32_t add_name(const char *a, size_t length);
+
+    /* computes bit ranges and column widths of register R, whose fields
+     * have been added to the field table with lo = offset from the most
+     * significant bit */
+    void compile(register_layout &R);
+
+    /* Appends one register_layout per register definition in a..end-1 to
+     * R, and their names to the name table.  a..end-1 is the part of the
+     * spec file that starts at offset base, after line lines_before.
+     * Register bodies (the field lines) are only located and checked for
+     * their widths, and their reserved bits added to the mask table, not
+     * parsed. */
+    void parse(const char *a, const char *end, uint64_t base,
+               size_t lines_before, std::vector<register_layout> &R);
+
+    /* parses the body a..end-1 of register R into the field table */
+    void parse_body(register_layout &R, const char *a, const char *end);
+
+    /* Appends the value table of field F, whose named values are V (value,
+     * name offset), to the value table. */
+    void add_values(field_extractor &F,
+                    std::vector<std::pair<uint64_t, uint32_t>> &V);
+
+    /* reads the body of register R from the spec file and parses it */
+    void load_body(register_layout &R);
+
+    /* maps the spec cache of filename if it is up to date; returns false if
+     * there is none or it cannot be used */
+    bool load_image(const char *filename);
+
+public:
+    static const char *const IMAGE_SUFFIX;
+
+    /* Reads the spec file filename, or its spec cache if use_image and the
+     * cache is up to date.  Throws reg_info_exception on errors. */
+    spec_file(const char *filename, bool use_image=true);
+
+    ~spec_file();
+
+    /* Writes the spec cache for the spec file this object was read from;
+     * MUST NOT be called if it was read from the cache.  Throws
+     * reg_info_exception on errors. */
+    void save_image();
+
+    /* Keeps a copy of the spec file as it was read, so that reload can
+     * tell which register definitions have changed. */
+    void keep_snapshot();
+
+    /* Reads the spec file again after it has changed, and parses again only
+     * the register definitions on lines that differ from the snapshot;
+     * the others keep their fields.  Sets removed and parsed to the number
+     * of definitions dropped and parsed again.  Returns false if the spec
+     * file must be read from scratch instead (no snapshot, registers
+     * defined more than once, or errors in the changed part).  Throws
+     * reg_info_exception if the file cannot be read; the registers stay as
+     * they were then. */
+    bool reload(uint32_t &removed, uint32_t &parsed);
+
+    /* Returns NULL if there is no register called regname.  The fields of
+     * a register are parsed the first time it is looked up, so this throws
+     * reg_info_exception if they contain errors. */
+    const register_layout *layout(const std::string &regname);
+
+    /* as layout, for the i-th register of the register table */
+    const register_layout *layout_at(uint32_t i);
+
+    /* FNV-1a hash of the length characters at a, as used by the index */
+    static inline uint32_t name_hash(const char *a, size_t length){
+        uint32_t hash = 2166136261u;
+        for(size_t i = 0; i < length; i++){
+            hash = (hash ^ (uint8_t)a[i]) * 16777619u;
+        }//for
+        return hash;
+    }//name_hash
+
+    inline const std::string &filename() const{
+        return source_name;
+    }//filename
+
+    inline const char *name(uint32_t offset) const{
+        return __names + offset;
+    }//name
+
+    /* hash function of hashed value tables */
+    static inline uint32_t value_hash(uint64_t v, uint32_t seed){
+        v ^= seed * UINT64_C(0x9e3779b97f4a7c15);
+        v = (v ^ (v >> 33)) * UINT64_C(0xff51afd7ed558ccd);
+        v = (v ^ (v >> 33)) * UINT64_C(0xc4ceb9fe1a85ec53);
+        return (uint32_t)(v ^ (v >> 33));
+    }//value_hash
+
+    /* Returns the name of value v of field F, or NULL if v has no name.
+     * F MUST NOT be wider than 64 bits. */
+    inline const char *value_name(const field_extractor &F, uint64_t v) const{
+        const uint32_t *T = __values + F.values;
+        uint32_t response;
+        switch(F.value_kind){
+        case DENSE_VALUE_NAMES:
+            response = T[v];
+            break;
+        case HASHED_VALUE_NAMES:{
+            uint32_t seed = T[value_hash(v, 0) & ((1u << F.bucket_bits) - 1)];
+            T += (1u << F.bucket_bits)
+                + 3 * (value_hash(v, seed) & ((1u << F.slot_bits) - 1));
+            response = T[0] == (uint32_t)v && T[1] == (uint32_t)(v >> 32)
+                ? T[2] : 0;
+            break;
+        }//case
+        default:
+            return NULL;
+        }//switch
+        return response ? __names + response - 1 : NULL;
+    }//value_name
+
+    /* returns the reserved-bit mask of R, (R.width + 63) / 64 limbs */
+    inline const uint64_t *reserved_mask(const register_layout &R) const{
+        return __masks + R.reserved;
+    }//reserved_mask
+
+    /* returns the first of the R.number_of_fields fields of R */
+    inline const field_extractor *fields_of(const register_layout &R) const{
+        return __fields + R.first_field;
+    }//fields_of
+
+    inline uint32_t number_of_registers() const{
+        return __number_of_registers;
+    }//number_of_registers
+
+    inline const register_layout &register_at(uint32_t i) const{
+        return __registers[i];
+    }//register_at
+
+    uint16_t max_number_of_fields(){
+        return __max_number_of_fields;
+    }//max_number_of_fields
+};
+
+#endif
+
+/* aczutro ************************************************************* end */
@@ -0,0 +1,76 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#ifndef text_codec_hh
+#define text_codec_hh text_codec_hh
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/*** namespace with conversions between text and limbs ***********************/
+
+namespace text_codec{
+
+    /* Converts the n hexadecimal digits (either case) at a into
+     * number_of_limbs limbs.  Digits that don't fit into the limbs are cut
+     * off (silently).  Returns false if a contains anything but hexadecimal
+     * digits; the limbs are undefined then.
+     * Uses SSE4.2 or AVX2 if the CPU supports it. */
+    bool parse_hex(const char *a, size_t n,
+                   uint64_t *limbs, uint8_t number_of_limbs);
+
+    /* Same as parse_hex, but for binary digits. */
+    bool parse_bin(const char *a, size_t n,
+                   uint64_t *limbs, uint8_t number_of_limbs);
+
+    /* Converts the n decimal digits at a into number_of_limbs limbs.
+     * MAKES NO SECURITY TESTS, i.e. a MUST be decimal.
+     * Returns false if the number doesn't fit into the limbs. */
+    bool parse_dec(const char *a, size_t n,
+                   uint64_t *limbs, uint8_t number_of_limbs);
+
+    /* Writes the least significant digits hexadecimal digits of limbs
+     * into a (most significant first, lowercase, not NUL-terminated). */
+    void render_hex(const uint64_t *limbs, uint8_t digits, char *a);
+
+    /* Same as render_hex, but writes the least significant bits binary
+     * digits. */
+    void render_bin(const uint64_t *limbs, uint16_t bits, char *a);
+
+    /* Same as render_bin, but puts separator between groups of 4 digits
+     * (counting from the least significant one).  Returns the number of
+     * characters written, i.e. bits + (bits - 1) / 4. */
+    size_t render_bin_groups(const uint64_t *limbs, uint16_t bits,
+                             char separator, char *a);
+
+    /* Writes the value of the number_of_limbs limbs as a decimal number
+     * into a (NUL-terminated) and returns the number of digits.
+     * a MUST have room for 20 * number_of_limbs + 1 characters.
+     * The limbs are used as scratch space, i.e. they are all-0s afterwards. */
+    size_t render_dec(uint64_t *limbs, uint8_t number_of_limbs, char *a);
+
+}//text_codec
+
+#endif
+
+/* aczutro ************************************************************* end */
@@ -0,0 +1,500 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#include <algorithm>
+#include <iostream>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <exceptions.hh>
+#include <limbs.hh>
+#include <text-codec.hh>
+#include <batch-decoder.hh>
+
+using namespace std;
+using namespace exceptions;
+
+
+/*** macros ************************************************************/
+
+#define MAX_WIDTH core_state::MAX_WIDTH
+#define MAX_LIMBS core_state::MAX_LIMBS
+
+/* output is handed to the stream in blocks of (at least) this size */
+#define OUTPUT_BLOCK_SIZE (1 << 16)
+
+/* input that cannot be memory-mapped is read in blocks of this size */
+#define INPUT_BLOCK_SIZE (1 << 20)
+
+/* memory-mapped input is split into chunks of about this size, which are
+ * decoded in parallel */
+#define CHUNK_SIZE (1 << 22)
+
+/* max number of chunks per job that may be decoded but not yet written */
+#define CHUNKS_IN_FLIGHT 2
+
+#define is_blank(ch) ((ch) == ' ' || (ch) == '\t' || (ch) == '\r')
+
+
+/*** class batch_decoder functions *************************************/
+
+batch_decoder::batch_decoder(reg_info *RI, const string &regname, bool diff,
+                             FILE *output){
+    register_ref R = RI->find(regname);
+    const register_layout *L = R.layout;
+    if(! L){
+        throw(UNKNOWN_REG_DEF);
+    }//if
+    if(L->width > core_state::MAX_NUMBER_OF_BITS){
+        throw(UNSUPPORTED_WIDTH);
+    }//if
+    number_of_bits = L->width;
+
+    file = R.file;
+    const field_extractor *F = R.file->fields_of(*L);
+    for(const field_extractor *end = F + L->number_of_fields; F < end; F++){
+        fields.push_back({string(" ") + R.file->name(F->name) + "=", *F});
+    }//for
+
+    this->diff = diff;
+    have_previous = false;
+    line_number = 0;
+    check = NULL;
+    stream = output;
+    autoflush = true;
+    out.reserve(2 * OUTPUT_BLOCK_SIZE);
+}//batch_decoder
+
+/*****************************************************************/
+
+batch_decoder::batch_decoder(const reserved_check *C, uint16_t number_of_bits,
+                             FILE *output){
+    this->number_of_bits = number_of_bits;
+    file = NULL;
+    diff = false;
+    have_previous = false;
+    line_number = 0;
+    check = C;
+    stream = output;
+    autoflush = true;
+}//batch_decoder
+
+/*****************************************************************/
+
+batch_decoder::~batch_decoder(){
+    flush();
+}//~batch_decoder
+
+/*****************************************************************/
+
+bool batch_decoder::read_value(const char *a, size_t n, size_t &digits){
+    const char *end = a + n;
+    while(a < end && is_blank(*a)){
+        a++;
+    }//while
+    while(a < end && is_blank(end[-1])){
+        end--;
+    }//while
+    if(a == end){
+        return false;
+    }//if
+    if(end - a > 2 && a[0] == '0' && (a[1] == 'x' || a[1] == 'X')){
+        a += 2;
+    }//if
+    digits = end - a;
+    while(end - a > 1 && *a == '0'){
+        a++;
+    }//while
+    if(! text_codec::parse_hex(a, end - a, value, MAX_LIMBS)){
+        throw(BAD_HEX_STRING);
+    }//if
+    if(end - a > MAX_WIDTH){
+        throw(BAD_VALUE_FOR_REG_WIDTH);
+    }//if
+    return true;
+}//read_value
+
+/*****************************************************************/
+
+bool batch_decoder::check_value(size_t digits){
+    uint16_t bits = number_of_bits;
+    if(! bits){
+        if(digits > MAX_WIDTH){
+            throw(BAD_VALUE_FOR_REG_WIDTH);
+        }//if
+        bits = digits * 4;
+    }//if
+    if(limbs::significant_bits(value, MAX_LIMBS) > bits){
+        throw(BAD_VALUE_FOR_REG_WIDTH);
+    }//if
+
+    if(! check->number_of_registers(bits)){
+        failure = NO_REGISTER_OF_WIDTH;
+        detail = to_string(bits);
+        return false;
+    }//if
+
+    violations.clear();
+    check->check(value, bits, violations, hits);
+    if(violations.empty()){
+        return true;
+    }//if
+    failure = RESERVED_BITS_SET;
+    detail.clear();
+    for(uint32_t i : violations){
+        if(! detail.empty()){
+            detail.append(", ");
+        }//if
+        detail.append(check->register_name(i));
+        detail.push_back(' ');
+        detail.append(check->set_bits(value, i));
+    }//for
+    return false;
+}//check_value
+
+/*****************************************************************/
+
+void batch_decoder::append_field(const field_extractor &F, const uint64_t *a){
+    uint16_t bits;
+    if(F.width() <= limbs::LIMB_BITS){
+        tmp_limbs[0] = F.value(a);
+        bits = limbs::significant_bits(tmp_limbs, 1);
+    }else{
+        F.extract(a, MAX_LIMBS, tmp_limbs);
+        bits = limbs::significant_bits(tmp_limbs, MAX_LIMBS);
+    }//else
+    uint8_t digits = bits ? (bits + 3) / 4 : 1;
+    size_t pos = out.length();
+    out.resize(pos + digits);
+    text_codec::render_hex(tmp_limbs, digits, &out[pos]);
+    if(F.value_kind != NO_VALUE_NAMES){
+        const char *name = file->value_name(F, tmp_limbs[0]);
+        if(name){
+            out.push_back('(');
+            out.append(name);
+            out.push_back(')');
+        }//if
+    }//if
+}//append_field
+
+/*****************************************************************/
+
+void batch_decoder::diff_value(){
+    bool differ = false;
+    uint64_t x[MAX_LIMBS];
+    for(uint8_t i = 0; i < MAX_LIMBS; i++){
+        x[i] = value[i] ^ previous[i];
+        differ = differ || x[i];
+    }//for
+    if(have_previous && differ){
+        out.append(to_string(line_number));
+        out.append(": ");
+        size_t pos = out.length();
+        out.resize(pos + number_of_bits / 4);
+        text_codec::render_hex(previous, number_of_bits / 4, &out[pos]);
+        out.append(" -> ");
+        pos = out.length();
+        out.resize(pos + number_of_bits / 4);
+        text_codec::render_hex(value, number_of_bits / 4, &out[pos]);
+        /* only the fields intersecting the XOR are decoded */
+        for(const field &f : fields){
+            if(f.F.intersects(x)){
+                out.append(f.prefix);
+                append_field(f.F, previous);
+                out.append("->");
+                append_field(f.F, value);
+            }//if
+        }//for
+        out.push_back('\n');
+    }//if
+    for(uint8_t i = 0; i < MAX_LIMBS; i++){
+        previous[i] = value[i];
+    }//for
+    have_previous = true;
+}//diff_value
+
+/*****************************************************************/
+
+void batch_decoder::decode(const char *a, size_t n){
+    size_t digits;
+    if(! read_value(a, n, digits)){
+        return;
+    }//if
+    if(check){
+        if(! check_value(digits)){
+            throw(failure);
+        }//if
+        return;
+    }//if
+    if(limbs::significant_bits(value, MAX_LIMBS) > number_of_bits){
+        throw(BAD_VALUE_FOR_REG_WIDTH);
+    }//if
+
+    if(diff){
+        diff_value();
+    }else{
+        size_t pos = out.length();
+        out.resize(pos + number_of_bits / 4);
+        text_codec::render_hex(value, number_of_bits / 4, &out[pos]);
+        for(const field &f : fields){
+            out.append(f.prefix);
+            append_field(f.F, value);
+        }//for
+        out.push_back('\n');
+    }//else
+
+    if(autoflush && out.length() >= OUTPUT_BLOCK_SIZE){
+        flush();
+    }//if
+}//decode
+
+/*****************************************************************/
+
+size_t batch_decoder::decode_lines(const char *begin, const char *end){
+    size_t l = 0;
+    while(begin < end){
+        const char *eol = (const char*)memchr(begin, '\n', end - begin);
+        if(! eol){
+            eol = end;
+        }//if
+        line_number++;
+        try{
+            /* most lines of a corrupt trace may fail a check, so that
+             * failure is recorded without throwing */
+            size_t digits;
+            if(! check){
+                decode(begin, eol - begin);
+            }else if(read_value(begin, eol - begin, digits)
+                     && ! check_value(digits)){
+                errors.push_back({l, failure, detail});
+            }//else if
+        }catch(signal e){
+            errors.push_back({l, e, ""});
+        }//catch
+        begin = eol + 1;
+        l++;
+    }//while
+    return l;
+}//decode_lines
+
+/*****************************************************************/
+
+size_t batch_decoder::report(const char *name, size_t first_line){
+    size_t response = errors.size();
+    if(response){
+        flush();
+        fflush(stream);
+        /* written at once, as there may be one error per line */
+        string text;
+        for(const line_error &error : errors){
+            text.append(name);
+            text.push_back(':');
+            text.append(to_string(first_line + error.line));
+            text.append(": ");
+            text.append(errmsg[error.e]);
+            if(! error.detail.empty()){
+                /* a width completes the message */
+                text.append(error.e == NO_REGISTER_OF_WIDTH ? " " : ": ");
+                text.append(error.detail);
+            }//if
+            text.push_back('\n');
+        }//for
+        cerr.write(text.data(), text.length());
+        cerr.flush();
+        errors.clear();
+    }//if
+    return response;
+}//report
+
+/*****************************************************************/
+
+size_t batch_decoder::run_parallel(const char *begin, const char *end,
+                                   const char *name, unsigned jobs){
+    /* split input into newline-aligned chunks */
+    vector<const char*> bounds(1, begin);
+    while(end - bounds.back() > CHUNK_SIZE){
+        const char *eol = (const char*)memchr(bounds.back() + CHUNK_SIZE,
+                                              '\n',
+                                              end - bounds.back() - CHUNK_SIZE);
+        if(! eol){
+            break;
+        }//if
+        bounds.push_back(eol + 1);
+    }//while
+    bounds.push_back(end);
+    size_t number_of_chunks = bounds.size() - 1;
+
+    /* results of chunk k are kept in slot k % number of slots until they
+     * have been written */
+    struct slot{
+        string out;
+        vector<line_error> errors;
+        size_t lines;
+        bool done;
+    };
+    vector<slot> slots(jobs * CHUNKS_IN_FLIGHT);
+    for(slot &S : slots){
+        S.done = false;
+    }//for
+
+    mutex m;
+    condition_variable chunk_done, chunk_written;
+    size_t next = 0;    // next chunk to be decoded
+    size_t written = 0; // number of chunks written so far
+
+    auto worker = [&](batch_decoder &D){
+        unique_lock<mutex> lock(m);
+        while(true){
+            chunk_written.wait(lock, [&](){
+                    return next >= number_of_chunks
+                        || next < written + slots.size();
+                });
+            if(next >= number_of_chunks){
+                return;
+            }//if
+            size_t k = next++;
+            lock.unlock();
+            slot &S = slots[k % slots.size()];
+            S.lines = D.decode_lines(bounds[k], bounds[k + 1]);
+            D.out.swap(S.out);
+            D.errors.swap(S.errors);
+            D.out.clear();
+            D.errors.clear();
+            lock.lock();
+            S.done = true;
+            chunk_done.notify_one();
+        }//while
+    };//worker
+
+    flush();
+    vector<batch_decoder> decoders(jobs, *this);
+    vector<thread> pool;
+    for(batch_decoder &D : decoders){
+        D.autoflush = false;
+        pool.emplace_back(worker, ref(D));
+    }//for
+
+    size_t response = 0;
+    size_t l = 1;
+    for(size_t k = 0; k < number_of_chunks; k++){
+        slot &S = slots[k % slots.size()];
+        {
+            unique_lock<mutex> lock(m);
+            chunk_done.wait(lock, [&](){return S.done;});
+        }
+        out.swap(S.out);
+        errors.swap(S.errors);
+        response += report(name, l);
+        flush();
+        l += S.lines;
+        {
+            lock_guard<mutex> lock(m);
+            S.done = false;
+            written++;
+        }
+        chunk_written.notify_all();
+    }//for
+
+    for(thread &t : pool){
+        t.join();
+    }//for
+    return response;
+}//run_parallel
+
+/*****************************************************************/
+
+size_t batch_decoder::run(int fd, const char *name, unsigned jobs){
+    struct stat st;
+    if(fstat(fd, &st)){
+        throw(reg_info_exception({"cannot read '", name, "'"}));
+    }//if
+
+    size_t errors = 0;
+
+    if(S_ISREG(st.st_mode)){
+        if(st.st_size == 0){
+            return 0;
+        }//if
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(map == MAP_FAILED){
+            throw(reg_info_exception({"cannot map '", name, "'"}));
+        }//if
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+        if(jobs > 1 && st.st_size > CHUNK_SIZE && ! diff){
+            errors = run_parallel((const char*)map,
+                                  (const char*)map + st.st_size, name, jobs);
+        }else{
+            decode_lines((const char*)map, (const char*)map + st.st_size);
+            errors = report(name, 1);
+        }//else
+        munmap(map, st.st_size);
+    }else{
+        /* decode complete lines from the buffer and move the incomplete
+         * last line to the front before reading the next block */
+        string buffer(INPUT_BLOCK_SIZE, 0);
+        size_t filled = 0;
+        size_t l = 1;
+        ssize_t r;
+        while((r = read(fd, &buffer[filled], buffer.size() - filled)) > 0){
+            filled += r;
+            const char *begin = buffer.data();
+            const char *eol = (const char*)memrchr(begin, '\n', filled);
+            if(! eol){
+                if(filled == buffer.size()){ // line longer than buffer
+                    buffer.resize(2 * buffer.size());
+                }//if
+                continue;
+            }//if
+            decode_lines(begin, eol);
+            errors += report(name, l);
+            l += count(begin, eol + 1, '\n');
+            filled -= eol + 1 - begin;
+            memmove(&buffer[0], eol + 1, filled);
+        }//while
+        if(r < 0){
+            flush();
+            throw(reg_info_exception({"cannot read '", name, "'"}));
+        }//if
+        decode_lines(buffer.data(), buffer.data() + filled);
+        errors += report(name, l);
+    }//else
+
+    flush();
+    return errors;
+}//run
+
+/*****************************************************************/
+
+void batch_decoder::flush(){
+    fwrite(out.data(), 1, out.length(), stream);
+    out.clear();
+}//flush
+
+/* aczutro ************************************************************* end */
@@ -57,8 +57,10 @@ command_line_reader::~command_line_reader(){
 /*****************************************************************/
 
 void command_line_reader::operator>>(char &command){
+    /* tokens are NUL-terminated as they are completed, so only empty tokens
+     * need to be reset */
     for(__i = 0; __i <= capacity; __i++){
-        memset(token[__i], 0, token_size);
+        token[__i][0] = 0;
     }//for
     __i = 0;
     __j = 0;
@@ -70,12 +72,14 @@ void command_line_reader::operator>>(char &command){
         switch(ch){
         case '\n':
             if(__j){
+                token[__i][__j] = 0;
                 __i++;
             }//if
             goto out_of_while;
         case ' ':
         case '\t':
             if(__j){
+                token[__i][__j] = 0;
                 __i++;
                 __j = 0;
             }//if
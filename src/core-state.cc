@@ -20,6 +20,7 @@
  *
  ******************************************************************* aczutro */
 
+#include <text-codec.hh>
 #include <core-state.hh>
 
 using namespace std;
@@ -27,34 +28,93 @@ using namespace std;
 
 /*** class core_state functions ****************************************/
 
+uint64_t core_state::packed_data() const{
+    return (uint64_t)__width
+        | (uint64_t)__digits << 8
+        | (uint64_t)__perm_hilite << 16
+        | (uint64_t)__perm_hilite_min << 24
+        | (uint64_t)__perm_hilite_max << 32
+        | (uint64_t)show_indices << 40;
+}//packed_data
+
+/*****************************************************************/
+
+void core_state::unpack_data(uint64_t a){
+    __width           = a;
+    __digits          = a >> 8;
+    __perm_hilite     = (a >> 16) & 1;
+    __perm_hilite_min = a >> 24;
+    __perm_hilite_max = a >> 32;
+    show_indices      = (a >> 40) & 1;
+}//unpack_data
+
+/*****************************************************************/
+
+uint8_t core_state::delta(const core_state &a, uint64_t *d) const{
+    uint8_t parts = 0;
+    for(uint8_t i = 0; i < MAX_LIMBS; i++){
+        if(__limbs[i] != a.__limbs[i]){
+            *d++ = __limbs[i] ^ a.__limbs[i];
+            parts |= 1 << i;
+        }//if
+    }//for
+    uint64_t data = packed_data() ^ a.packed_data();
+    if(data){
+        *d = data;
+        parts |= 1 << MAX_LIMBS;
+    }//if
+    return parts;
+}//delta
+
+/*****************************************************************/
+
+core_state &core_state::apply_delta(uint8_t parts, const uint64_t *d){
+    for(uint8_t i = 0; i < MAX_LIMBS; i++){
+        if(parts & 1 << i){
+            __limbs[i] ^= *d++;
+        }//if
+    }//for
+    if(parts & 1 << MAX_LIMBS){
+        unpack_data(packed_data() ^ *d);
+    }//if
+    return *this;
+}//apply_delta
+
+/*****************************************************************/
+
+string core_state::hex(){
+    string response(__digits, '0');
+    text_codec::render_hex(__limbs, __digits, &response[0]);
+    return response;
+}//hex
+
+/*****************************************************************/
+
 core_state &core_state::adjust_to_width(){
     if(__width){
-        if(__width > __hex.length()){
-            __hex.insert(0, string(__width - __hex.length(), '0'));
-        }else{
-            __hex.erase(0, __hex.length() - __width);
-        }//else
+        __digits = __width;
+        limbs::truncate(__limbs, MAX_LIMBS, __width * 4);
     }else{
-        index = __hex.find_first_not_of('0');
-        if(index == string::npos){ // i.e. a is all-0s
-            __hex = "0";
-        }else{
-            __hex.erase(0, index);
-        }//else
+        __digits = (limbs::significant_bits(__limbs, MAX_LIMBS) + 3) / 4;
+        if(! __digits){ // i.e. value is all-0s
+            __digits = 1;
+        }//if
     }//else
     return *this;
 }//adjust_to_width
 
 /*****************************************************************/
 
-core_state &core_state::operator=(const string &a){
-    __hex = a;
+core_state &core_state::set_value(const uint64_t *a){
+    for(uint8_t i = 0; i < MAX_LIMBS; i++){
+        __limbs[i] = a[i];
+    }//for
     adjust_to_width();
     if(__perm_hilite){
         set_perm_hilite(__perm_hilite_min, __perm_hilite_max);
     }//
     return *this;
-}//operator=
+}//set_value
 
 /*****************************************************************/
 
@@ -21,12 +21,16 @@
  ******************************************************************* aczutro */
 
 #include <iostream>
+#include <algorithm>
+#include <vector>
 
-#include <cassert>
 #include <cstring>
 
 #include <colours.hh>
 #include <exceptions.hh>
+#include <limbs.hh>
+#include <text-codec.hh>
+#include <reserved-check.hh>
 #include <core.hh>
 
 using namespace std;
@@ -36,242 +40,143 @@ using namespace exceptions;
 /*** macros ************************************************************/
 
 #define DEFAULT_WIDTH 8
-#define MAX_WIDTH 16
-#define MAX_NUMBER_OF_BITS (MAX_WIDTH * 4)
-#define DEFAULT_HISTORY_CAPACITY 16
+#define MAX_WIDTH core_state::MAX_WIDTH
+#define MAX_NUMBER_OF_BITS core_state::MAX_NUMBER_OF_BITS
+#define MAX_LIMBS core_state::MAX_LIMBS
+#define DEFAULT_HISTORY_CAPACITY 14
+#define MAX_HISTORY_SIZE UINT32_MAX
+#define DEFAULT_HISTORY_BUDGET 65536 // KiB
+#define MAX_HISTORY_BUDGET UINT32_MAX
 #define SEPARATOR ' '
 
 
 /*** help functions and constants for conversions **********************/
 
-static const uintmax_t __pow[] = {
-    1u,                   // 2 ^ 0
-    2u,                   // 2 ^ 1
-    4u,                   // 2 ^ 2
-    8u,                   // 2 ^ 3
-    16u,                  // 2 ^ 4
-    32u,                  // 2 ^ 5
-    64u,                  // 2 ^ 6
-    128u,                 // 2 ^ 7
-    256u,                 // 2 ^ 8
-    512u,                 // 2 ^ 9
-    1024u,                // 2 ^ 10
-    2048u,                // 2 ^ 11
-    4096u,                // 2 ^ 12
-    8192u,                // 2 ^ 13
-    16384u,               // 2 ^ 14
-    32768u,               // 2 ^ 15
-    65536u,               // 2 ^ 16
-    131072u,              // 2 ^ 17
-    262144u,              // 2 ^ 18
-    524288u,              // 2 ^ 19
-    1048576u,             // 2 ^ 20
-    2097152u,             // 2 ^ 21
-    4194304u,             // 2 ^ 22
-    8388608u,             // 2 ^ 23
-    16777216u,            // 2 ^ 24
-    33554432u,            // 2 ^ 25
-    67108864u,            // 2 ^ 26
-    134217728u,           // 2 ^ 27
-    268435456u,           // 2 ^ 28
-    536870912u,           // 2 ^ 29
-    1073741824u,          // 2 ^ 30
-    2147483648u,          // 2 ^ 31
-    4294967296u,          // 2 ^ 32
-    8589934592u,          // 2 ^ 33
-    17179869184u,         // 2 ^ 34
-    34359738368u,         // 2 ^ 35
-    68719476736u,         // 2 ^ 36
-    137438953472u,        // 2 ^ 37
-    274877906944u,        // 2 ^ 38
-    549755813888u,        // 2 ^ 39
-    1099511627776u,       // 2 ^ 40
-    2199023255552u,       // 2 ^ 41
-    4398046511104u,       // 2 ^ 42
-    8796093022208u,       // 2 ^ 43
-    17592186044416u,      // 2 ^ 44
-    35184372088832u,      // 2 ^ 45
-    70368744177664u,      // 2 ^ 46
-    140737488355328u,     // 2 ^ 47
-    281474976710656u,     // 2 ^ 48
-    562949953421312u,     // 2 ^ 49
-    1125899906842624u,    // 2 ^ 50
-    2251799813685248u,    // 2 ^ 51
-    4503599627370496u,    // 2 ^ 52
-    9007199254740992u,    // 2 ^ 53
-    18014398509481984u,   // 2 ^ 54
-    36028797018963968u,   // 2 ^ 55
-    72057594037927936u,   // 2 ^ 56
-    144115188075855872u,  // 2 ^ 57
-    288230376151711744u,  // 2 ^ 58
-    576460752303423488u,  // 2 ^ 59
-    1152921504606846976u, // 2 ^ 60
-    2305843009213693952u, // 2 ^ 61
-    4611686018427387904u, // 2 ^ 62
-    9223372036854775808u  // 2 ^ 63
-};
-
-static uintmax_t pow(uint8_t exp){
-    if(exp < 64){
-        return __pow[exp];
-    }else{
-        return 2 * pow(exp - 1);
-    }//else
-}//pow
-
 /* returns number of decimal digits needed to represent a */
-static uint8_t log(uint8_t a){
-    if(a < 10){
-        return 1;
-    }else if(a < 100){
-        return 2;
-    }else{
-        return 3;
-    }//else
+static uint8_t log(uint16_t a){
+    uint8_t response = 1;
+    for(; a >= 10; a /= 10){
+        response++;
+    }//for
+    return response;
 }//log
 
-inline static uint8_t hex2dec(char a){
-    return a - (a > '9' ? 'a' - 10 : '0');
-}//hex2dec
-
 static const char dec2hex[] = "0123456789abcdef";
 
-static const char hex2bin[][5] = {
-  "0000",
-  "0001",
-  "0010",
-  "0011",
-  "0100",
-  "0101",
-  "0110",
-  "0111",
-  "1000",
-  "1001",
-  "1010",
-  "1011",
-  "1100",
-  "1101",
-  "1110",
-  "1111"
-};
-
-inline static char bool2char(bool a){
-    return a ? '1' : '0';
-}//bool2char
-
+/* prints the name and the bit range of field F of register L of file S, the
+ * index column padded by index_padding for single-bit fields */
+static void print_field_label(const spec_file *S, const register_layout *L,
+                              const field_extractor *F, uint8_t index_padding){
+    cout << string(L->name_width - F->name_length, ' ')
+         << S->name(F->name);
+    if(F->hi == F->lo){
+        cout << " [" << string(L->index_width - log(F->hi), ' ')
+             << F->hi << "]" << string(index_padding, ' ');
+    }else{
+        cout << " [" << string(L->index_width - log(F->hi), ' ')
+             << F->hi << ".."
+             << string(L->index_width - log(F->lo), ' ')
+             << F->lo << "]";
+    }//else
+}//print_field_label
+
+/* Returns field F of value a in hex, followed by the value's name in
+ * parentheses if it has one in file S.  b is scratch space. */
+static string field_text(const spec_file *S, const field_extractor *F,
+                         const uint64_t *a, uint64_t *b){
+    F->extract(a, core_state::MAX_LIMBS, b);
+    uint16_t bits = limbs::significant_bits(b, core_state::MAX_LIMBS);
+    string response(bits ? (bits + 3) / 4 : 1, '0');
+    text_codec::render_hex(b, response.length(), &response[0]);
+    const char *name = F->value_kind != NO_VALUE_NAMES
+        ? S->value_name(*F, b[0]) : NULL;
+    if(name){
+        response.append("(").append(name).append(")");
+    }//if
+    return response;
+}//field_text
 
-/*** class core functions **********************************************/
+/* Sets line to label (in print colour) followed by columns characters to be
+ * filled in by the caller, and returns pointer to the first of those. */
+static char *open_line(string &line, const char *label, size_t columns){
+    line.assign(C_PRINT).append(label).append(DEFF);
+    size_t pos = line.length();
+    line.resize(pos + columns);
+    return &line[pos];
+}//open_line
 
-void core::init_history(){
-    delete[] H;
-    H = new core_state[history_index::history_size()];
-    bottom = 0;
-    top = 0;
-    history_push();
-}//init_history
 
-/*****************************************************************/
+/*** class core functions **********************************************/
 
 void core::history_push(){
-    if((top + 1) == bottom){
-        bottom++;
-    }//if
-    H[top()] = C;
-    top++;
-    last_push = top;
-    no_redo = true;
-    //@debug __print_history();
+    H.push(C);
 }//history_push
 
 /*****************************************************************/
 
 void core::history_pop(){
-    if((top - 1) == bottom){
+    if(! H.undo(C)){
         throw(EMPTY_UNDO_HISTORY);
     }//if
-    top--;
-    C = H[(top - 1)()];
-    no_redo = false;
-    //@debug __print_history();
 }//history_pop
 
 /*****************************************************************/
 
 void core::history_unpop(){
-    if(no_redo || top == last_push){
+    if(! H.redo(C)){
         throw(EMPTY_REDO_HISTORY);
     }//if
-    top++;
-    C = H[(top - 1)()];
-    //@debug __print_history();
 }//history_unpop
 
 /*****************************************************************/
 
-void core::__print_history(){
-    cout << "HISTORY" << endl;
-    for(uint8_t i = 0; i < history_index::history_size(); i++){
-        if(i == bottom() && i == top()){
-            cout << "|> ";
-        }else if(i == bottom()){
-            cout << "|- ";
-        }else if(i == top()){
-            cout << "-> ";
-        }else if(i == last_push()){
-            cout << " . ";
-        }else{
-            cout << "   ";
-        }//else
-        cout << i << ": ";
-        H[i].print();
-        cout << endl;
-    }//for
-    cout << "END" << endl;
-}//__print_history
+void core::history_switch(bool forward){
+    if(! H.switch_branch(forward, C)){
+        throw(NO_OTHER_BRANCH);
+    }//if
+}//history_switch
 
 /*****************************************************************/
 
 void core::print_history(){
-    if(bottom == last_push){
-        cout << "no undo history";
-        return;
-    } /* end if(bottom == last_push) */
+    vector<history::entry> E;
+    size_t current = H.entries(E);
     cout << "undo history:";
-    for(history_index i = bottom; i != last_push; i++){
+    for(size_t i = 0; i < E.size(); i++){
         cout << endl;
-        if((i + 1) == top)
+        if(i == current)
             cout << "-> ";
         else
             cout << "   ";
-        H[i()].print();
+        E[i].state.print();
+        if(E[i].branches > 1){
+            cout << "  branch " << E[i].branch << "/" << E[i].branches;
+        }//if
     }//for
 }//print_history
 
 /*****************************************************************/
 
-core::core(){
+core::core() : H(DEFAULT_HISTORY_CAPACITY + 1,
+                 DEFAULT_HISTORY_BUDGET * 1024, C){
     C.show_indices = true;
     C.reset_perm_hilite();
     C.set_width(DEFAULT_WIDTH);
-    C = "0";
-
-    H = NULL;
-    history_index::history_size(DEFAULT_HISTORY_CAPACITY);
-    init_history();
+    H.reset(H.capacity(), H.budget(), C);
 
-    tmp_hex = new char[MAX_WIDTH + 1];
+    tmp_text = new char[MAX_NUMBER_OF_BITS + 1];
     line1.reserve(MAX_NUMBER_OF_BITS);
     line2.reserve(MAX_NUMBER_OF_BITS);
     line3.reserve(MAX_NUMBER_OF_BITS);
     line4.reserve(MAX_NUMBER_OF_BITS);
     line5.reserve(MAX_NUMBER_OF_BITS);
+    line6.reserve(MAX_NUMBER_OF_BITS);
 }//core
 
 /*****************************************************************/
 
 core::~core(){
-    delete[] tmp_hex;
-    delete[] H;
+    delete[] tmp_text;
 }//~core
 
 /*****************************************************************/
@@ -289,55 +194,55 @@ void core::turn_on_perm_hilite(uint16_t a, uint16_t b, bool push){
 /*****************************************************************/
 
 core &core::set_to(char mode, const string &a){
+    for(uint8_t i = 0; i < MAX_LIMBS; i++){
+        tmp_limbs[i] = 0;
+    }//for
     switch(mode){
     case 'b':
-        if(a.length() > MAX_NUMBER_OF_BITS){
-            sprintf(tmp_hex, "%llx",
-                    strtoull(a.substr(a.length() - MAX_NUMBER_OF_BITS).c_str(),
-                             NULL, 2)
-                    );
-        }else{
-            sprintf(tmp_hex, "%llx", strtoull(a.c_str(), NULL, 2));
-        }//else
-        tmp_string = tmp_hex;
+        if(! text_codec::parse_bin(a.c_str(), a.length(),
+                                   tmp_limbs, MAX_LIMBS)){
+            throw(BAD_BIN_STRING);
+        }//if
         break;
     case 'd':
-        sprintf(tmp_hex, "%llx", strtoull(a.c_str(), NULL, 10));
-        if(C.width() && C.width() < strlen(tmp_hex)){
+        if((! text_codec::parse_dec(a.c_str(), a.length(),
+                                    tmp_limbs, MAX_LIMBS))
+           || (C.width() && C.width() * 4 < limbs::significant_bits(
+                                                tmp_limbs, MAX_LIMBS))){
             throw(BAD_VALUE_FOR_WIDTH);
         }//if
-        tmp_string = tmp_hex;
         break;
     default: // assuming 'h'
-        tmp_string = a;
+        if(! text_codec::parse_hex(a.c_str(), a.length(),
+                                   tmp_limbs, MAX_LIMBS)){
+            throw(BAD_HEX_STRING);
+        }//if
         break;
     }//switch
 
-    if(tmp_string.length() > MAX_WIDTH){
-        C = tmp_string.substr(tmp_string.length() - MAX_WIDTH);
-    }else{
-        C = tmp_string;
-    }//else
+    C.set_value(tmp_limbs);
     history_push();
     return *this;
 }//set_to
 
 /*****************************************************************/
 
-void core::resize_history(uint8_t a){
+void core::resize_history(uintmax_t a, uintmax_t kib){
     if(a < 1){
         throw(HISTORY_SIZE_SMALL);
     }//if
-    if(a + 2 > history_index::MAX_HISTORY_SIZE){
+    if(a >= MAX_HISTORY_SIZE || kib > MAX_HISTORY_BUDGET){
         throw(HISTORY_SIZE_LARGE);
     }//if
-    history_index::history_size(a + 2);
-    init_history();
+    if(kib < 1){
+        throw(HISTORY_BUDGET_SMALL);
+    }//if
+    H.resize(a + 1, kib * 1024);
 }//resize_history
 
 /*****************************************************************/
 
-core &core::set_width(uint8_t a){
+core &core::set_width(uint16_t a){
     if(a == C.width()){
         return *this;
     }//if
@@ -361,14 +266,7 @@ core &core::invert(uint8_t lo, uint8_t hi){
         throw(BAD_INV_LIMITS);
     }//if
 
-    for(uint8_t i = (C.number_of_bits() - 1 - hi);
-        i < (C.number_of_bits() - lo); i++){
-        tmp_byte1 = i / 4;
-        C.replace_nibble(tmp_byte1,
-                         dec2hex[hex2dec(C.hex()[tmp_byte1])
-                                 ^ pow((C.number_of_bits() - 1 - i) % 4)]
-                         );
-    }//for
+    C.flip_range(lo, hi);
 
     if(! C.width()){
         C.adjust_to_width();
@@ -384,45 +282,33 @@ core &core::replace(char mode, const string &a){
     if(! C.perm_hilite()){
         throw(NO_HILITE);
     }//if
+    for(uint8_t i = 0; i < MAX_LIMBS; i++){
+        tmp_limbs[i] = 0;
+    }//for
     switch(mode){
     case 'b':
-        tmp_string = a;
+        if(! text_codec::parse_bin(a.c_str(), a.length(),
+                                   tmp_limbs, MAX_LIMBS)){
+            throw(BAD_BIN_STRING);
+        }//if
         break;
     case 'd':
-        tmp_dec = strtoull(a.c_str(), NULL, 10);
-        if(tmp_dec > pow(C.perm_hilite_max() - C.perm_hilite_min() + 1) - 1){
+        if((! text_codec::parse_dec(a.c_str(), a.length(),
+                                    tmp_limbs, MAX_LIMBS))
+           || (limbs::significant_bits(tmp_limbs, MAX_LIMBS)
+               > C.perm_hilite_max() - C.perm_hilite_min() + 1)){
             throw(BAD_VALUE_FOR_PERM_WIDTH);
         }//if
-        tmp_string = "";
-        sprintf(tmp_hex, "%llx", (unsigned long long)tmp_dec);
-        for(char *ch = tmp_hex; *ch; ch++){
-            tmp_string.append(hex2bin[hex2dec(*ch)]);
-        }//for
         break;
     default: // assuming 'h'
-        tmp_string = "";
-        for(char ch : a){
-            tmp_string.append(hex2bin[hex2dec(ch)]);
-        }//for
+        if(! text_codec::parse_hex(a.c_str(), a.length(),
+                                   tmp_limbs, MAX_LIMBS)){
+            throw(BAD_HEX_STRING);
+        }//if
         break;
     }//switch
 
-    string::reverse_iterator rit = tmp_string.rbegin();
-    for(uint8_t i = C.number_of_bits() - 1 - C.perm_hilite_min();
-        i > C.number_of_bits() - 2 - C.perm_hilite_max(); i--){
-        tmp_byte1 = i / 4;
-        tmp_byte2 = (C.number_of_bits() - 1 - i) % 4;
-        if(rit != tmp_string.rend()){
-            tmp_hex[0] = *rit;
-            rit++;
-        }else{
-            tmp_hex[0] = '0'; // replacement_string was too short, so padding with 0s
-        }//else
-        C.replace_nibble(tmp_byte1,
-                         dec2hex[(hex2dec(C.hex()[tmp_byte1]) | pow(tmp_byte2))
-                                 - (('1' - tmp_hex[0]) * pow(tmp_byte2))]
-                         );
-    }//for
+    C.deposit(C.perm_hilite_min(), C.perm_hilite_max(), tmp_limbs);
 
     if(! C.width()){
         C.adjust_to_width();
@@ -456,37 +342,57 @@ void core::print(bool hilite_now, uint8_t lo, uint8_t hi){
 
     /* basic output **************************************/
 
-    tmp_dec = strtoull(C.hex().c_str(), NULL, 16);
-    if(errno){
-        errno = 0;
-    }else{
-        cout << C_PRINT << "decimal: " << DEFF
-             << C_HILITE_3 << tmp_dec << DEFF << endl;
-    }//else
-
-    line1 = string(C_PRINT) + "    hex: " + DEFF;
-    line2 = string(C_PRINT) + "    bin: " + DEFF;
-    line3 = string(C_PRINT) + "         " + DEFF;
-    line4 = string(C_PRINT) + "indices: " + DEFF;
-    line5 = string(C_PRINT) + "         " + DEFF;
-
-    for(uint8_t i = 0; i < C.hex().length(); i++){
-        line1.append(1, SEPARATOR).append("   ").append(1, C.hex()[i]);
-        tmp_byte1 = hex2dec(C.hex()[i]);
-        line2.append(string(1, SEPARATOR)
-                     + bool2char(tmp_byte1 & 8)
-                     + bool2char(tmp_byte1 & 4)
-                     + bool2char(tmp_byte1 & 2)
-                     + bool2char(tmp_byte1 & 1)
-                     );
-        line3.append("+----");
-        tmp_byte1 = C.number_of_bits() - (4 * i) - 1;
-        line4.append(string(1, SEPARATOR) + to_string(tmp_byte1 / 10)
-                     + "  " + to_string((tmp_byte1 - 3) / 10));
-        line5.append(string(1, SEPARATOR) + to_string(tmp_byte1 % 10)
-                     + "  " + to_string((tmp_byte1 - 3) % 10));
+    for(uint8_t i = 0; i < MAX_LIMBS; i++){
+        tmp_limbs[i] = C.limbs()[i];
+    }//for
+    text_codec::render_dec(tmp_limbs, MAX_LIMBS, tmp_text);
+    cout << C_PRINT << "decimal: " << DEFF
+         << C_HILITE_3 << tmp_text << DEFF << endl;
+
+    /* indices need 3 lines (hundreds, tens, units) if there are 3-digit
+     * indices, 2 lines otherwise */
+    bool three_index_lines = C.number_of_bits() > 100;
+
+    /* every nibble takes 5 columns: separator plus 4 characters */
+    uint16_t columns = 5 * C.digits();
+    char *hex_line = open_line(line1, "    hex: ", columns);
+    char *bin_line = open_line(line2, "    bin: ", columns);
+    char *ruler    = open_line(line3, "         ", columns + 1);
+    char *index4   = open_line(line4, "indices: ", columns);
+    char *index5   = open_line(line5, "         ", columns);
+    char *index6   = open_line(line6, "         ", columns);
+
+    bin_line[0] = SEPARATOR;
+    text_codec::render_bin_groups(C.limbs(), C.number_of_bits(), SEPARATOR,
+                                  bin_line + 1);
+    ruler[columns] = '+';
+
+    for(uint16_t i = 0; i < columns; i += 5){
+        memset(hex_line + i, ' ', 5);
+        hex_line[i] = SEPARATOR;
+        hex_line[i + 4] = dec2hex[C.nibble(C.digits() - 1 - i / 5)];
+        memcpy(ruler + i, "+----", 5);
+        tmp_byte1 = C.number_of_bits() - (4 * i / 5) - 1;
+        tmp_byte2 = tmp_byte1 - 3;
+        memset(index4 + i, ' ', 5);
+        memset(index5 + i, ' ', 5);
+        index4[i] = index5[i] = SEPARATOR;
+        if(three_index_lines){
+            memset(index6 + i, ' ', 5);
+            index6[i] = SEPARATOR;
+            index4[i + 1] = '0' + tmp_byte1 / 100;
+            index4[i + 4] = '0' + tmp_byte2 / 100;
+            index5[i + 1] = '0' + tmp_byte1 / 10 % 10;
+            index5[i + 4] = '0' + tmp_byte2 / 10 % 10;
+            index6[i + 1] = '0' + tmp_byte1 % 10;
+            index6[i + 4] = '0' + tmp_byte2 % 10;
+        }else{
+            index4[i + 1] = '0' + tmp_byte1 / 10;
+            index4[i + 4] = '0' + tmp_byte2 / 10;
+            index5[i + 1] = '0' + tmp_byte1 % 10;
+            index5[i + 4] = '0' + tmp_byte2 % 10;
+        }//else
     }//for
-    line3.append("+");
 
     if((! C.perm_hilite()) && (! hilite_now)){
         cout << line1 << endl << line2;
@@ -494,6 +400,9 @@ void core::print(bool hilite_now, uint8_t lo, uint8_t hi){
             cout << endl << line3
                  << endl << line4
                  << endl << line5;
+            if(three_index_lines){
+                cout << endl << line6;
+            }//if
         }//if
         return;
     }//if
@@ -509,48 +418,42 @@ void core::print(bool hilite_now, uint8_t lo, uint8_t hi){
         cout << endl << hilite_line(line3)
              << endl << hilite_line(line4)
              << endl << hilite_line(line5);
+        if(three_index_lines){
+            cout << endl << hilite_line(line6);
+        }//if
     }//if
 
     /* details on highlighted part ***********************/
 
-    hilited_hex = "";
-    hilited_string = "";
-    for(uint16_t i = left_ins; i <= right_ins; i++){
-        if(line2[i] != SEPARATOR){
-            hilited_string.push_back(line2[i]);
-        }//if
-    }//for
+    C.extract(lo, hi, tmp_limbs);
+    uint16_t bits = hi - lo + 1;
 
-    cout << endl << "highlighted bin: " << BOLD << C_HILITE_2;
-    tmp_byte1 = 0;
-    for(uint16_t i = 0; i < hilited_string.length(); i++){
-        cout << hilited_string[i];
-        tmp_byte2 = (hilited_string.length() - 1 - i) % 4;
-        tmp_byte1 += ((hilited_string[i] - '0') * pow(tmp_byte2));
-        if(tmp_byte2 == 0){
-            assert(tmp_byte1 < 16);
-            hilited_hex.append(1, dec2hex[tmp_byte1]);
-            tmp_byte1 = 0;
-            if(i != (hilited_string.length() - 1)){
-                cout << SEPARATOR;
-            }//if
+    hilited_string.resize(bits + (bits - 1) / 4);
+    text_codec::render_bin_groups(tmp_limbs, bits, SEPARATOR,
+                                  &hilited_string[0]);
+
+    /* every hex digit goes below the last bit of its group, and every bit
+     * is followed by a separator */
+    hilited_hex.assign(bits + (bits + 3) / 4, SEPARATOR);
+    char *ch = &hilited_hex[0];
+    for(uint16_t i = bits; i > 0; i--){
+        if((i - 1) % 4 == 0){
+            *ch++ = dec2hex[(tmp_limbs[(i - 1) / 64] >> ((i - 1) % 64)) & 0xf];
         }//if
-        hilited_hex.append(1, SEPARATOR);
+        ch++;
     }//for
 
-    cout << DEFF
+    cout << endl
+         << "highlighted bin: " << BOLD << C_HILITE_2 << hilited_string
+         << DEFF
          << endl
          << "highlighted hex: " << BOLD << C_HILITE_2 << hilited_hex
          << DEFF;
 
-    hilited_dec = strtoull(hilited_string.c_str(), NULL, 2);
-    if(errno){
-        errno = 0;
-    }else{
-        cout << endl
-             << "highlighted dec: " << BOLD << C_HILITE_2 << hilited_dec
-             << DEFF;
-    }//else
+    text_codec::render_dec(tmp_limbs, MAX_LIMBS, tmp_text);
+    cout << endl
+         << "highlighted dec: " << BOLD << C_HILITE_2 << tmp_text
+         << DEFF;
 }//print
 
 /*****************************************************************/
@@ -559,109 +462,205 @@ void core::print_registers(reg_info *RI){
 
     cout << "available register definitions:";
 
-    for(register_data entry = RI->RD().begin();
-        entry != RI->RD().end(); entry++){
-        cout << endl << "    " << entry->first;
+    vector<const char*> names;
+    for(uint32_t i = 0; i < RI->number_of_registers(); i++){
+        names.push_back(RI->register_name(i));
+    }//for
+    sort(names.begin(), names.end(),
+         [](const char *a, const char *b){return strcmp(a, b) < 0;});
+    for(const char *name : names){
+        cout << endl << "    " << name;
     }//for
 
 }//print_registers
 
 /*****************************************************************/
 
+void core::print_matches(reg_info *RI, const string &pattern){
+
+    vector<string> matches = RI->search(pattern);
+    if(matches.empty()){
+        cout << "no matching registers or fields";
+        return;
+    }//if
+    cout << "matching registers and fields:";
+    for(const string &match : matches){
+        cout << endl << "    " << match;
+    }//for
+
+}//print_matches
+
+/*****************************************************************/
+
+void core::check_reserved(reg_info *RI, const string &regname){
+
+    uint16_t bits = C.number_of_bits();
+    reserved_check K = regname.empty() ? reserved_check(RI)
+        : reserved_check(RI, regname);
+    if(! regname.empty() && ! K.number_of_registers(bits)){
+        throw(INCOMP_REG_WIDTH);
+    }//if
+
+    vector<uint32_t> violations;
+    vector<uint64_t> hits;
+    K.check(C.limbs(), bits, violations, hits);
+    if(! violations.empty()){
+        cout << "reserved bits set in:";
+        for(uint32_t i : violations){
+            cout << endl << "    " << K.register_name(i) << " "
+                 << BOLD << C_HILITE_1 << K.set_bits(C.limbs(), i) << DEFF;
+        }//for
+    }else if(! regname.empty()){
+        cout << "no reserved bits of " << regname << " set";
+    }else if(K.number_of_registers(bits)){
+        cout << "no reserved bits set in any of the "
+             << K.number_of_registers(bits) << " registers of width "
+             << bits;
+    }else{
+        cout << "no register definitions of width " << bits;
+    }//else
+
+}//check_reserved
+
+/*****************************************************************/
+
 void core::print_register(reg_info *RI, const string &regname){
-    if(RI->RD().find(regname) == RI->RD().end()){
+    register_ref R = RI->find(regname);
+    const register_layout *L = R.layout;
+    if(! L){
         throw(UNKNOWN_REG_DEF);
     }//if
-    const field_data *F = RI->RD().at(regname);
-    if(F->width != C.number_of_bits()){
+    if(L->width != C.number_of_bits()){
         throw(INCOMP_REG_WIDTH);
     }//if
-    F = F->next;
-
-    uint8_t max_fname_length = regname.length();
-    uint8_t max_bin_length = 3;
-    bool multi_index = false;
-    while(F){
-        if(F->name.length()){ // if string not empty
-            if(F->width > 1){
-                multi_index = true;
-            }//if
-            if(F->name.length() > max_fname_length){
-                max_fname_length = F->name.length();
-            }//if
-            if(F->width > max_bin_length){
-                max_bin_length = F->width;
-            }//if
-        }//if
-        F = F->next;
-    }//while
-    uint8_t max_hex_length = max(3,
-                                 (max_bin_length / 4)
-                                 + (max_bin_length % 4 ? 1 : 0)
-                                 );
-    uint8_t index_width = log(C.number_of_bits() - 1);
-
-    uint8_t tot_sgl_idx_wd = 3 + index_width;
-    uint8_t tot_idx_wd_diff = multi_index ? 2 + index_width : 0;
+
+    uint8_t tot_sgl_idx_wd = 3 + L->index_width;
+    uint8_t tot_idx_wd_diff = L->multi_index ? 2 + L->index_width : 0;
     uint8_t tot_mlt_idx_wd = tot_sgl_idx_wd + tot_idx_wd_diff;
 
-    cout << string(max_fname_length - regname.length(), ' ')
+    cout << string(L->name_width - regname.length(), ' ')
          << regname
          << string(tot_mlt_idx_wd, ' ')
-         << "   " << BOLD << C_HILITE_1 << "bin" << string(max_bin_length - 3, ' ') << DEFF
-         << "   " << BOLD << C_HILITE_2 << "hex" << string(max_hex_length - 3, ' ') << DEFF
+         << "   " << BOLD << C_HILITE_1 << "bin" << string(L->bin_width - 3, ' ') << DEFF
+         << "   " << BOLD << C_HILITE_2 << "hex" << string(L->hex_width - 3, ' ') << DEFF
          << "   " << BOLD << C_HILITE_3 << "dec" << DEFF
          << endl
-         << string(max_fname_length + tot_mlt_idx_wd + max_bin_length
-                   + max_hex_length + 12,
+         << string(L->name_width + tot_mlt_idx_wd + L->bin_width
+                   + L->hex_width + 12,
                    '-');
 
-    line1 = "";
-    for(char ch : C.hex()){
-        tmp_byte1 = hex2dec(ch);
-        line1.append(string("")
-                     + bool2char(tmp_byte1 & 8)
-                     + bool2char(tmp_byte1 & 4)
-                     + bool2char(tmp_byte1 & 2)
-                     + bool2char(tmp_byte1 & 1)
-                     );
+    /* value names go into a column of their own, behind dec */
+    size_t dec_width = 0;
+    const field_extractor *F = R.file->fields_of(*L);
+    for(const field_extractor *end = F + L->number_of_fields; F < end; F++){
+        if(F->value_kind != NO_VALUE_NAMES){
+            dec_width = max(dec_width, (size_t)(F->width() * 0.30103) + 1);
+        }//if
     }//for
 
-    F = RI->RD().at(regname)->next;
-
-    uint16_t left_ins, right_ins;
-    uint16_t i = 0;
-    while(F){
-        if(F->name.length()){ // if string not empty
-            hilited_string = line1.substr(i, F->width);
-            hilited_dec = strtoull(hilited_string.c_str(), NULL, 2);
-            hilited_hex = "";
-            sprintf(tmp_hex, "%llx", (unsigned long long)hilited_dec);
-            hilited_hex.append(tmp_hex);
-            left_ins = C.number_of_bits() - i - 1;
-            right_ins = C.number_of_bits() - i - F->width;
-            cout << endl
-                 << string(max_fname_length - F->name.length(), ' ')
-                 << F->name;
-            if(left_ins == right_ins){
-                cout << " [" << string(index_width - log(left_ins), ' ')
-                     << left_ins << "]" << string(tot_idx_wd_diff, ' ');
-            }else{
-                cout << " [" << string(index_width - log(left_ins), ' ')
-                     << left_ins << ".."
-                     << string(index_width - log(right_ins), ' ')
-                     << right_ins << "]";
-            }//else
-            cout << " = " << BOLD << C_HILITE_1 << hilited_string
-                 << string(max_bin_length - hilited_string.length(), ' ')
-                 << DEFF << "   " << BOLD << C_HILITE_2 << hilited_hex
-                 << string(max_hex_length - hilited_hex.length(), ' ')
-                 << DEFF << "   " << BOLD << C_HILITE_3 << hilited_dec
-                 << DEFF << flush;
+    uint16_t bits;
+    const char *value_name;
+    size_t dec_length;
+    F = R.file->fields_of(*L);
+    for(const field_extractor *end = F + L->number_of_fields; F < end; F++){
+        F->extract(C.limbs(), MAX_LIMBS, tmp_limbs);
+        value_name = F->value_kind != NO_VALUE_NAMES
+            ? R.file->value_name(*F, tmp_limbs[0]) : NULL;
+        hilited_string.resize(F->width());
+        text_codec::render_bin(tmp_limbs, F->width(), &hilited_string[0]);
+        bits = limbs::significant_bits(tmp_limbs, MAX_LIMBS);
+        hilited_hex.assign(bits ? (bits + 3) / 4 : 1, '0');
+        text_codec::render_hex(tmp_limbs, hilited_hex.length(),
+                               &hilited_hex[0]);
+        dec_length = text_codec::render_dec(tmp_limbs, MAX_LIMBS, tmp_text);
+        cout << endl;
+        print_field_label(R.file, L, F, tot_idx_wd_diff);
+        cout << " = " << BOLD << C_HILITE_1 << hilited_string
+             << string(L->bin_width - hilited_string.length(), ' ')
+             << DEFF << "   " << BOLD << C_HILITE_2 << hilited_hex
+             << string(L->hex_width - hilited_hex.length(), ' ')
+             << DEFF << "   " << BOLD << C_HILITE_3 << tmp_text
+             << DEFF;
+        if(value_name){
+            cout << string(dec_width - dec_length, ' ') << "   "
+                 << value_name;
         }//if
-        i += F->width;
-        F = F->next;
-    }//while
+        cout << flush;
+    }//for
 }//print_register
 
+/*****************************************************************/
+
+void core::print_diff(reg_info *RI, const string &regname, const string &a){
+    register_ref R = RI->find(regname);
+    const register_layout *L = R.layout;
+    if(! L){
+        throw(UNKNOWN_REG_DEF);
+    }//if
+    if(L->width != C.number_of_bits()){
+        throw(INCOMP_REG_WIDTH);
+    }//if
+    uint64_t other[MAX_LIMBS];
+    if(! text_codec::parse_hex(a.c_str(), a.length(), other, MAX_LIMBS)){
+        throw(BAD_HEX_STRING);
+    }//if
+    size_t first = a.find_first_not_of('0');
+    if((first != string::npos && a.length() - first > MAX_WIDTH)
+       || limbs::significant_bits(other, MAX_LIMBS) > L->width){
+        throw(BAD_VALUE_FOR_REG_WIDTH);
+    }//if
+
+    /* the fields that differ are those that intersect the XOR */
+    uint64_t x[MAX_LIMBS];
+    bool differ = false;
+    for(uint8_t i = 0; i < MAX_LIMBS; i++){
+        x[i] = C.limbs()[i] ^ other[i];
+        differ = differ || x[i];
+    }//for
+    vector<const field_extractor*> fields;
+    vector<string> texts; // old and new value of each field
+    size_t old_width = 3, new_width = 3;
+    const field_extractor *F = R.file->fields_of(*L);
+    for(const field_extractor *end = F + L->number_of_fields;
+        differ && F < end; F++){
+        if(F->intersects(x)){
+            fields.push_back(F);
+            texts.push_back(field_text(R.file, F, C.limbs(), tmp_limbs));
+            texts.push_back(field_text(R.file, F, other, tmp_limbs));
+            old_width = max(old_width, texts[texts.size() - 2].length());
+            new_width = max(new_width, texts.back().length());
+        }//if
+    }//for
+    if(! differ){
+        cout << "the values are equal";
+        return;
+    }//if
+    if(fields.empty()){
+        cout << "no fields of " << regname << " differ, only unused bits";
+        return;
+    }//if
+
+    uint8_t tot_sgl_idx_wd = 3 + L->index_width;
+    uint8_t tot_idx_wd_diff = L->multi_index ? 2 + L->index_width : 0;
+    uint8_t tot_mlt_idx_wd = tot_sgl_idx_wd + tot_idx_wd_diff;
+
+    cout << string(L->name_width - regname.length(), ' ')
+         << regname
+         << string(tot_mlt_idx_wd, ' ')
+         << "   " << BOLD << C_HILITE_1 << "old" << string(old_width - 3, ' ') << DEFF
+         << "   " << BOLD << C_HILITE_2 << "new" << DEFF
+         << endl
+         << string(L->name_width + tot_mlt_idx_wd + old_width + new_width + 6,
+                   '-');
+    for(size_t i = 0; i < fields.size(); i++){
+        cout << endl;
+        print_field_label(R.file, L, fields[i], tot_idx_wd_diff);
+        cout << " = " << BOLD << C_HILITE_1 << texts[2 * i]
+             << string(old_width - texts[2 * i].length(), ' ')
+             << DEFF << "   " << BOLD << C_HILITE_2 << texts[2 * i + 1]
+             << DEFF;
+    }//for
+    cout << flush;
+}//print_diff
+
 /* aczutro ************************************************************* end */
@@ -22,13 +22,20 @@
  ******************************************************************* aczutro */
 
 #include <iostream>
+#include <map>
+#include <thread>
 
+#include <cstdlib>
 #include <cstring>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <colours.hh>
 #include <exceptions.hh>
 #include <command-line-reader.hh>
 #include <core.hh>
+#include <batch-decoder.hh>
 
 using namespace std;
 using namespace exceptions;
@@ -38,11 +45,13 @@ using namespace exceptions;
 
 #define HEXCALC_VERSION "2.0"
 
-#define HELP_BUFFER_LENGTH 1800
+#define HELP_BUFFER_LENGTH 2560
+
+#define MAX_NUMBER_OF_ARGS 32
 
 #define __error cout << BOLD << C_ERROR << "error: " << DEFF << " "
 
-#define isbindigit(ch) ((ch == '0') || (ch == '1'))
+#define __warning cout << BOLD << C_ERROR << "warning: " << DEFF << " "
 
 #define QUIT          "q"
 #define HELP          "h"
@@ -58,9 +67,15 @@ using namespace exceptions;
 #define REDO          "r"
 #define HISTORY_SIZE  "U"
 #define PRINT_HISTORY "H"
+#define NEXT_BRANCH   ">"
+#define PREV_BRANCH   "<"
 #define SPLIT_FIELDS  "s"
 #define SPLIT_REPEAT  "S"
 #define LOAD_SPECS    "R"
+#define WATCH_SPECS   "W"
+#define FIND_NAMES    "/"
+#define CHECK_RESERVED "V"
+#define DIFF_FIELDS   "x"
 
 #define CMD_QUIT          QUIT[0]
 #define CMD_HELP          HELP[0]
@@ -76,9 +91,15 @@ using namespace exceptions;
 #define CMD_REDO          REDO[0]
 #define CMD_HISTORY_SIZE  HISTORY_SIZE[0]
 #define CMD_PRINT_HISTORY PRINT_HISTORY[0]
+#define CMD_NEXT_BRANCH   NEXT_BRANCH  [0]
+#define CMD_PREV_BRANCH   PREV_BRANCH  [0]
 #define CMD_SPLIT_FIELDS  SPLIT_FIELDS[0]
 #define CMD_SPLIT_REPEAT  SPLIT_REPEAT[0]
 #define CMD_LOAD_SPECS    LOAD_SPECS  [0]
+#define CMD_WATCH_SPECS   WATCH_SPECS [0]
+#define CMD_FIND_NAMES    FIND_NAMES  [0]
+#define CMD_CHECK_RESERVED CHECK_RESERVED[0]
+#define CMD_DIFF_FIELDS   DIFF_FIELDS [0]
 
 #define __cmd(str) BOLD C_HELP_CMD str DEFF
 
@@ -88,11 +109,128 @@ using namespace exceptions;
 
 #define __print_errmsg catch(signal e){__error << errmsg[e];}
 
+#define BATCH_USAGE "usage: hexcalc [--decode REGISTER [--diff] --spec PATH... [--jobs N] [TRACE_FILE]]\n" \
+                    "       hexcalc --check-reserved [--decode REGISTER] --spec PATH... [--jobs N] [TRACE_FILE]\n" \
+                    "       hexcalc --compile-spec PATH... [--jobs N]"
+
+
+/*** batch mode **************************************************************/
+
+/* Runs D on the file trace, or on stdin if trace is NULL.  Returns the
+ * number of erroneous lines. */
+static size_t run_trace(batch_decoder &D, const char *trace, unsigned jobs){
+    int fd = trace ? open(trace, O_RDONLY) : STDIN_FILENO;
+    if(fd < 0){
+        throw(reg_info_exception({"cannot open file '", trace, "'"}));
+    }//if
+    size_t errors = D.run(fd, trace ? trace : "<stdin>", jobs);
+    if(trace){
+        close(fd);
+    }//if
+    return errors;
+}//run_trace
+
+/*****************************************************************/
+
+/* Runs hexcalc non-interactively as specified by the command line arguments.
+ * Returns the exit status: 0 on success, 1 if some input lines could not be
+ * decoded, 2 on usage or set-up errors. */
+static int batch_main(int argc, char *argv[]){
+    const char *regname = NULL;
+    vector<string> specs;
+    const char *trace = NULL;
+    vector<string> compile;
+    bool check = false;
+    bool diff = false;
+    unsigned jobs = thread::hardware_concurrency();
+
+    for(int i = 1; i < argc; i++){
+        if(! strcmp(argv[i], "--decode") && i + 1 < argc){
+            regname = argv[++i];
+        }else if(! strcmp(argv[i], "--spec") && i + 1 < argc){
+            specs.push_back(argv[++i]);
+        }else if(! strcmp(argv[i], "--check-reserved")){
+            check = true;
+        }else if(! strcmp(argv[i], "--diff")){
+            diff = true;
+        }else if(! strcmp(argv[i], "--compile-spec") && i + 1 < argc){
+            compile.push_back(argv[++i]);
+        }else if(! strcmp(argv[i], "--jobs") && i + 1 < argc){
+            int n = atoi(argv[++i]);
+            if(n < 1){
+                cerr << BATCH_USAGE << endl;
+                return 2;
+            }//if
+            jobs = n;
+        }else if(! strcmp(argv[i], "--help")){
+            cout << BATCH_USAGE << endl;
+            return 0;
+        }else if(argv[i][0] != '-' && ! trace){
+            trace = argv[i];
+        }else{
+            cerr << BATCH_USAGE << endl;
+            return 2;
+        }//else
+    }//for
+    if(! compile.empty()){
+        if(regname || ! specs.empty() || trace || check || diff){
+            cerr << BATCH_USAGE << endl;
+            return 2;
+        }//if
+        try{
+            reg_info RI(compile, jobs, false);
+            RI.save_images();
+            return 0;
+        }//try
+        catch(exception &e){
+            cerr << "hexcalc: " << e.what() << endl;
+            return 2;
+        }//catch
+    }//if
+    if((! regname && ! check) || (check && diff) || specs.empty()){
+        cerr << BATCH_USAGE << endl;
+        return 2;
+    }//if
+
+    reg_info *RI = NULL;
+    try{
+        RI = new reg_info(specs, jobs);
+        for(const string &warning : RI->warnings()){
+            cerr << "hexcalc: warning: " << warning << endl;
+        }//for
+        size_t errors;
+        if(check){
+            reserved_check K = regname ? reserved_check(RI, regname)
+                : reserved_check(RI);
+            batch_decoder D(&K, regname ? RI->find(regname).layout->width : 0);
+            errors = run_trace(D, trace, jobs);
+        }else{
+            batch_decoder D(RI, regname, diff);
+            errors = run_trace(D, trace, jobs);
+        }//else
+        delete RI;
+        return errors ? 1 : 0;
+    }//try
+    catch(signal e){
+        cerr << "hexcalc: " << (regname ? regname : "") << ": " << errmsg[e]
+             << endl;
+    }//catch
+    catch(exception &e){
+        cerr << "hexcalc: " << e.what() << endl;
+    }//catch
+    delete RI;
+    return 2;
+}//batch_main
+
 
 /*** main ********************************************************************/
 
 int main(int argc, char *argv[]){
 
+    if(argc > 1){
+        return batch_main(argc, argv);
+    }//if
+
     reg_info *RI = NULL;
 
     /* set up some constants and declare main variables **************/
@@ -121,9 +259,15 @@ int main(int argc, char *argv[]){
         auto __redo          = __cmd(REDO         );
         auto __history_size  = __cmd(HISTORY_SIZE );
         auto __print_history = __cmd(PRINT_HISTORY);
+        auto __next_branch   = __cmd(NEXT_BRANCH  );
+        auto __prev_branch   = __cmd(PREV_BRANCH  );
         auto __split_fields  = __cmd(SPLIT_FIELDS );
         auto __split_repeat  = __cmd(SPLIT_REPEAT );
         auto __load_specs    = __cmd(LOAD_SPECS   );
+        auto __watch_specs   = __cmd(WATCH_SPECS  );
+        auto __find_names    = __cmd(FIND_NAMES   );
+        auto __check_reserved = __cmd(CHECK_RESERVED);
+        auto __diff_fields   = __cmd(DIFF_FIELDS  );
 
         char help_buffer[HELP_BUFFER_LENGTH];
 
@@ -142,12 +286,17 @@ int main(int argc, char *argv[]){
 \n\
 %s\n\
   %s Undo.            %s Redo.             %s Print undo history.\n\
-  %s %s Set undo history capacity.      %s Print current history capacity.\n\
+  %s Next branch.     %s Previous branch.\n\
+  %s %s [%s] Set history capacity.  %s Print current history capacity.\n\
 \n\
 %s\n\
   %s %s Print register info.        %s Repeat last \"%s %s\" command.\n\
   %s          Print available registers.\n\
-  %s %s     Load register specs from file %s.\n\
+  %s %s  Load register specs from files or directories.\n\
+  %s          Toggle watching spec files for changes.\n\
+  %s %s  Find registers and fields by name.\n\
+  %s %s Check reserved bits.        %s Check all registers of this width.\n\
+  %s %s %s Print fields that differ from %s.\n\
 \n\
 %s\n\
   %s Quit.                          %s         Print this text.\n\
@@ -165,11 +314,16 @@ int main(int argc, char *argv[]){
                 __replace, __arg("HEX_No"), __cmd("'b"), __arg("BIN_No"), __cmd("'d"), __arg("DEC_No"),
                 __title("History commands"),
                 __undo, __redo, __print_history,
-                __history_size, __arg("SIZE"), __history_size,
+                __next_branch, __prev_branch,
+                __history_size, __arg("SIZE"), __arg("KIB"), __history_size,
                 __title("Register information commands"),
                 __split_fields, __arg("REGISTER"), __split_repeat, __split_fields, __arg("REGISTER"),
                 __split_fields,
-                __load_specs, __arg("FILE"), __arg("FILE"),
+                __load_specs, __arg("PATH..."),
+                __watch_specs,
+                __find_names, __arg("PATTERN"),
+                __check_reserved, __arg("REGISTER"), __check_reserved,
+                __diff_fields, __arg("REGISTER"), __arg("HEX_No"), __arg("HEX_No"),
                 __title("Common commands"),
                 __quit, __help,
                 __version, __help, __arg("COMMAND"), __arg("COMMAND")
@@ -217,14 +371,30 @@ int main(int argc, char *argv[]){
         help_on[CMD_REDO] = help_buffer;
 
         sprintf(help_buffer,
-                "%s  Print the current undo history.", __print_history);
+                "%s  Print the current undo history: the steps up to the current one,\n\
+          and the ones that can be redone from there.  Steps made after an\n\
+          undo start a new branch, shown as \"branch N/M\".", __print_history);
         help_on[CMD_PRINT_HISTORY] = help_buffer;
 
-        sprintf(help_buffer, "%s %s  Set the undo history capacity to %s.\n\
-               (Deletes current history!)\n\
-       %s       Print the current undo history capacity.",
+        sprintf(help_buffer,
+                "%s  Switch to the next branch made at the previous step, i.e. replace\n\
+          the current step with the same step of the next branch.  Redo\n\
+          follows the branch visited last.", __next_branch);
+        help_on[CMD_NEXT_BRANCH] = help_buffer;
+
+        sprintf(help_buffer,
+                "%s  Switch to the previous branch made at the previous step (see %s).",
+                __prev_branch, __next_branch);
+        help_on[CMD_PREV_BRANCH] = help_buffer;
+
+        sprintf(help_buffer, "%s %s      Set the undo history capacity to %s steps.\n\
+       %s %s %s  Also set its memory budget to %s KiB (default 65536).\n\
+                   When either is exceeded, the oldest steps are forgotten.\n\
+       %s           Print the current undo history capacity, budget and\n\
+                   memory use.",
                 __history_size, __arg("SIZE"),
                 __arg("SIZE"),
+                __history_size, __arg("SIZE"), __arg("KIB"), __arg("KIB"),
                 __history_size);
         help_on[CMD_HISTORY_SIZE] = help_buffer;
 
@@ -269,15 +439,19 @@ int main(int argc, char *argv[]){
 
         sprintf(help_buffer, "%s %s  Print the value of the individual fields of register\n\
                    %s if that register had the same contents as the\n\
-                   accumulator.\n\
+                   accumulator.  %s may be abbreviated to any prefix\n\
+                   that only one register name starts with.\n\
        %s           Print list of available register definitions.",
                 __split_fields, __arg("REGISTER"),
-                __arg("REGISTER"),
+                __arg("REGISTER"), __arg("REGISTER"),
                 __split_fields);
         help_on[CMD_SPLIT_FIELDS] = help_buffer;
 
-        sprintf(help_buffer, "%s %s  Load register specs from file %s.\n\
-               %s must be a plain text file that specifies any number of\n\
+        sprintf(help_buffer, "%s %s  Load register specs from the spec files %s.\n\
+               A directory stands for all files in it and its\n\
+               subdirectories, except hidden files and spec caches.  If\n\
+               several files define the same register, the last one wins.\n\
+               A spec file is a plain text file that specifies any number of\n\
                registers and the bit fields those registers are composed of.\n\
                The specification of a register is as follows:\n\
                    %s0 REGISTER_NAME\n\
@@ -289,25 +463,30 @@ int main(int argc, char *argv[]){
                Fields are specified in order from left to right, one per\n\
                line.  If a line lacks a field name, the amount of bits\n\
                specified in that line are interpreted as unused bits; such\n\
-               bits are not listed by the %s command.  The sum of all field\n\
-               widths must equal the register's width in bits.  The total\n\
-               width must be divisible by 4 and it must match the number of\n\
-               bits of the accumulator when the %s command is run.\n\
+               bits are not listed by the %s command.  Lines\n\
+                   = VALUE VALUE_NAME\n\
+               after a field's line give names to values of that field;\n\
+               VALUE is decimal, or hexadecimal with prefix 0x.\n\
+               The sum of all field widths must equal the register's width\n\
+               in bits.  The total width must be divisible by 4 and it must\n\
+               match the number of bits of the accumulator when the %s\n\
+               command is run.\n\
                An example specification:\n\
                    %s0 cause\n\
                    11\n\
                    16 addr\n\
                    1 addr_valid\n\
                    4 errcode\n\
+                   = 12 overflow\n\
                    0%s\n\
                This defines a (fictitious) 32-bit register called 'cause',\n\
                whose bits 3..0 are used to store the error code\n\
-               corresponding to the failure caused by the last instruction.\n\
+               corresponding to the failure caused by the last instruction\n\
+               (12 meaning an overflow).\n\
                Bit 4 is a flag that indicates whether the failure involves\n\
                an address, and bits 20..5 are used to store that address.\n\
                Bits 31..21 are not used.",
-                __load_specs, __arg("FILE"), __arg("FILE"),
-                __arg("FILE"),
+                __load_specs, __arg("PATH..."), __arg("PATH..."),
                 C_PROMPT,
                 DEFF,
                 __split_fields,
@@ -316,6 +495,38 @@ int main(int argc, char *argv[]){
                 DEFF );
         help_on[CMD_LOAD_SPECS] = help_buffer;
 
+        sprintf(help_buffer, "%s  Toggle watching the loaded spec files for changes.\n\
+          While watching, spec files that have changed are read again\n\
+          before the next command runs.  Only the register definitions\n\
+          that have changed are parsed again.  The accumulator and the\n\
+          register shown by %s stay as they are.",
+                __watch_specs, __split_repeat);
+        help_on[CMD_WATCH_SPECS] = help_buffer;
+
+        sprintf(help_buffer, "%s %s  List the registers and fields whose names contain %s.\n\
+             In %s, '*' stands for any sequence of characters; a\n\
+             pattern with '*' must match the whole name.  Fields are\n\
+             listed as REGISTER.FIELD.",
+                __find_names, __arg("PATTERN"), __arg("PATTERN"),
+                __arg("PATTERN"));
+        help_on[CMD_FIND_NAMES] = help_buffer;
+
+        sprintf(help_buffer, "%s %s  Check if any reserved bits of register %s are set\n\
+                   in the accumulator.  Reserved bits are those of fields\n\
+                   without a name.\n\
+       %s             Check the reserved bits of all registers as wide as the\n\
+                   accumulator.",
+                __check_reserved, __arg("REGISTER"), __arg("REGISTER"),
+                __check_reserved);
+        help_on[CMD_CHECK_RESERVED] = help_buffer;
+
+        sprintf(help_buffer, "%s %s %s  Print the fields of register %s whose values\n\
+                         differ between the accumulator (old) and %s\n\
+                         (new).  Unused bits are not compared.",
+                __diff_fields, __arg("REGISTER"), __arg("HEX_No"),
+                __arg("REGISTER"), __arg("HEX_No"));
+        help_on[CMD_DIFF_FIELDS] = help_buffer;
+
         sprintf(help_buffer, "%s%shexcalc%s %sv. %s%s\n\
 %sCopyright 2014 - 2017 Alexander Czutro%s\n\
 %sThis program is free software: you can redistribute it and/or modify%s\n\
@@ -351,10 +562,11 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
     core A; // the "accumulator"
     string suffix;
     string last_register;
+    bool watch_specs = false;
 
     /* initialise command line reader and print welcome text *********/
 
-    command_line_reader R(256, 2);
+    command_line_reader R(512, MAX_NUMBER_OF_ARGS);
     cout << version_text << endl << endl << intro << flush;
 
     /* run the main loop, consisiting of
@@ -376,6 +588,20 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
             }
         }//catch
 
+        if(RI && RI->watching()){
+            vector<string> reports, warnings, errors;
+            RI->refresh(reports, warnings, errors);
+            for(const string &report : reports){
+                cout << report << endl;
+            }//for
+            for(const string &warning : warnings){
+                __warning << warning << endl;
+            }//for
+            for(const string &error : errors){
+                __error << error << endl;
+            }//for
+        }//if
+
         switch(command){
 
         case SELF_INSERT:
@@ -400,11 +626,6 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
                         A.set_to('d', suffix);
                         break;
                     case 'b':
-                        for(char ch : suffix){
-                            if(! isbindigit(ch)){
-                                throw(BAD_BIN_STRING);
-                            }//if
-                        }//for
                         A.set_to('b', suffix);
                         break;
                     default:
@@ -412,12 +633,6 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
                     }//switch
                 }//else if
                 else{
-                    for(char &ch : token){
-                        if(! isxdigit(ch)){
-                            throw(BAD_HEX_STRING);
-                        }//if
-                        ch = tolower(ch);
-                    }//for
                     A.set_to('h', token);
                 }//else
                 A.print();
@@ -468,6 +683,14 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
             }__print_errmsg;
             break;
 
+        case CMD_NEXT_BRANCH:
+        case CMD_PREV_BRANCH:
+            try{
+                A.switch_branch(command == CMD_NEXT_BRANCH);
+                A.print();
+            }__print_errmsg;
+            break;
+
         case CMD_INDICES:
             A.toggle_indices();
             A.print();
@@ -545,15 +768,24 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
         case CMD_HISTORY_SIZE:
             if(R.get_number_of_args()){
                 try{
-                    if(R.is_not_pos_dec(0)){
+                    if(R.is_not_pos_dec(0)
+                       || (R.get_number_of_args() > 1
+                           && R.is_not_pos_dec(1))){
                         throw(IS_NOT_POS_DEC);
                     }//if
-                    A.resize_history(R.get_num(0));
+                    A.resize_history(R.get_num(0),
+                                     R.get_number_of_args() > 1
+                                     ? R.get_num(1)
+                                     : A.get_history_budget());
                     cout << "undo history capacity set to "
-                         << (uint)A.get_history_size();
+                         << A.get_history_size()
+                         << ", memory budget to "
+                         << A.get_history_budget() << " KiB";
                 }__print_errmsg;
             }else{
-                cout << (uint)A.get_history_size();
+                cout << A.get_history_size() << " (memory budget "
+                     << A.get_history_budget() << " KiB, "
+                     << A.get_history_memory() << " KiB used)";
             }//else
             break;
 
@@ -613,11 +845,6 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
                             A.replace('d', suffix);
                             break;
                         case 'b':
-                            for(char ch : suffix){
-                                if(! isbindigit(ch)){
-                                    throw(BAD_BIN_STRING);
-                                }//if
-                            }//for
                             A.replace('b', suffix);
                             break;
                         default:
@@ -625,12 +852,6 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
                         }//switch
                     }//else if
                     else{
-                        for(char &ch : token){
-                            if(! isxdigit(ch)){
-                                throw(BAD_HEX_STRING);
-                            }//if
-                            ch = tolower(ch);
-                        }//for
                         A.replace('h', token);
                     }//else
                     A.print();
@@ -645,9 +866,25 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
             }
             if(R.get_number_of_args()){
                 try{
-                    A.print_register(RI, R.get_string(0));
-                    last_register = R.get_string(0);
-                }__print_errmsg;
+                    /* a unique prefix stands for the whole name */
+                    string regname = R.get_string(0);
+                    vector<string> completions = RI->complete(regname);
+                    if(completions.size() == 1){
+                        regname = completions[0];
+                    }else if(completions.size() > 1
+                             && completions[0] != regname){
+                        cout << "possible completions:";
+                        for(const string &completion : completions){
+                            cout << endl << "    " << completion;
+                        }//for
+                        break;
+                    }//else if
+                    A.print_register(RI, regname);
+                    last_register = regname;
+                }__print_errmsg
+                catch(reg_info_exception &e){
+                    __error << e.what();
+                }//catch
             }else{
                 A.print_registers(RI);
             }//else
@@ -660,18 +897,31 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
             }
             try{
                 A.print_register(RI, last_register);
-            }__print_errmsg;
+            }__print_errmsg
+            catch(reg_info_exception &e){
+                __error << e.what();
+            }//catch
             break;
 
         case CMD_LOAD_SPECS:
             if(R.get_number_of_args() == 0){
                 __error << "load command expects an argument";
             }else{
+                vector<string> paths;
+                for(uint8_t i = 0; i < R.get_number_of_args(); i++){
+                    paths.push_back(R.get_string(i));
+                }//for
                 delete RI;
                 RI = NULL;
                 try{
-                    RI = new reg_info(R.get_string(0));
+                    RI = new reg_info(paths, thread::hardware_concurrency());
+                    for(const string &warning : RI->warnings()){
+                        __warning << warning << endl;
+                    }//for
                     A.print_registers(RI);
+                    if(watch_specs){
+                        RI->watch();
+                    }//if
                 }//try
                 catch(exception &e){
                     __error << e.what();
@@ -679,6 +929,70 @@ accumulator to \"47\", you can enter \"%s%s2f%s\" (hex), \"%s%s'b101111%s\" (bin
             }//else
             break;
 
+        case CMD_WATCH_SPECS:
+            if(! RI){
+                __error << "need to load register specs first";
+                break;
+            }
+            watch_specs = ! RI->watching();
+            try{
+                if(watch_specs){
+                    RI->watch();
+                    cout << "watching spec files for changes";
+                }else{
+                    RI->unwatch();
+                    cout << "not watching spec files any more";
+                }//else
+            }//try
+            catch(reg_info_exception &e){
+                watch_specs = false;
+                __error << e.what();
+            }//catch
+            break;
+
+        case CMD_FIND_NAMES:
+            if(! RI){
+                __error << "need to load register specs first";
+                break;
+            }
+            if(R.get_number_of_args() != 1){
+                __error << "find command expects one argument";
+                break;
+            }
+            A.print_matches(RI, R.get_string(0));
+            break;
+
+        case CMD_DIFF_FIELDS:
+            if(! RI){
+                __error << "need to load register specs first";
+                break;
+            }
+            if(R.get_number_of_args() != 2){
+                __error << "diff command expects two arguments";
+                break;
+            }
+            try{
+                A.print_diff(RI, R.get_string(0), R.get_string(1));
+            }__print_errmsg
+            catch(reg_info_exception &e){
+                __error << e.what();
+            }//catch
+            break;
+
+        case CMD_CHECK_RESERVED:
+            if(! RI){
+                __error << "need to load register specs first";
+                break;
+            }
+            try{
+                A.check_reserved(RI, R.get_number_of_args()
+                                 ? R.get_string(0) : "");
+            }__print_errmsg
+            catch(reg_info_exception &e){
+                __error << e.what();
+            }//catch
+            break;
+
         default:
             __error << errmsg[BAD_HEX_STRING];
 
@@ -0,0 +1,310 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#include <algorithm>
+
+#include <history.hh>
+
+using namespace std;
+
+
+/*** static functions ********************************************************/
+
+static inline uint8_t number_of_words(uint8_t parts){
+    return __builtin_popcount(parts);
+}//number_of_words
+
+
+/*** class history functions *************************************************/
+
+history::history(size_t capacity, size_t budget, const core_state &C){
+    reset(capacity, budget, C);
+}//history
+
+/*****************************************************************/
+
+void history::reset(size_t capacity, size_t budget, const core_state &C){
+    max_entries = capacity;
+    max_bytes = budget;
+    current = C;
+    nodes.clear();
+    free_nodes.clear();
+    words.clear();
+    for(auto &f : free_words){
+        f.clear();
+    }//for
+    live_nodes = 0;
+    live_words = 0;
+    root = cur = new_node(0, NULL);
+}//reset
+
+/*****************************************************************/
+
+uint32_t history::new_node(uint8_t parts, const uint64_t *d){
+    uint32_t i;
+    if(free_nodes.empty()){
+        i = nodes.size();
+        nodes.emplace_back();
+    }else{
+        i = free_nodes.back();
+        free_nodes.pop_back();
+    }//else
+    node &N = nodes[i];
+    N.parent = N.first_child = N.active = NONE;
+    N.next = N.prev = i;
+    N.parts = parts;
+
+    uint8_t n = number_of_words(parts);
+    if(! n){
+        N.offset = 0;
+    }else if(free_words[n].empty()){
+        N.offset = words.size();
+        words.insert(words.end(), d, d + n);
+    }else{
+        N.offset = free_words[n].back();
+        free_words[n].pop_back();
+        copy(d, d + n, words.begin() + N.offset);
+    }//else
+    live_nodes++;
+    live_words += n;
+    return i;
+}//new_node
+
+/*****************************************************************/
+
+void history::free_difference(uint32_t i){
+    uint8_t n = number_of_words(nodes[i].parts);
+    if(n){
+        free_words[n].push_back(nodes[i].offset);
+        live_words -= n;
+    }//if
+    nodes[i].parts = 0;
+}//free_difference
+
+/*****************************************************************/
+
+void history::free_subtree(uint32_t i){
+    vector<uint32_t> stack(1, i);
+    while(! stack.empty()){
+        uint32_t j = stack.back();
+        stack.pop_back();
+        uint32_t c = nodes[j].first_child;
+        if(c != NONE){
+            do{
+                stack.push_back(c);
+                c = nodes[c].next;
+            }while(c != nodes[j].first_child);
+        }//if
+        free_difference(j);
+        free_nodes.push_back(j);
+        live_nodes--;
+    }//while
+}//free_subtree
+
+/*****************************************************************/
+
+void history::unlink(uint32_t i){
+    node &N = nodes[i];
+    node &P = nodes[N.parent];
+    if(N.next == i){
+        P.first_child = NONE;
+    }else{
+        nodes[N.prev].next = N.next;
+        nodes[N.next].prev = N.prev;
+        if(P.first_child == i){
+            P.first_child = N.next;
+        }//if
+    }//else
+    if(P.active == i){
+        P.active = P.first_child;
+    }//if
+    N.parent = NONE;
+    N.next = N.prev = i;
+}//unlink
+
+/*****************************************************************/
+
+void history::apply(uint32_t i){
+    current.apply_delta(nodes[i].parts, words.data() + nodes[i].offset);
+}//apply
+
+/*****************************************************************/
+
+void history::drop_root(){
+    uint32_t k = nodes[root].active;
+    unlink(k);
+    free_subtree(root);
+    /* the new root needs no difference */
+    free_difference(k);
+    root = k;
+}//drop_root
+
+/*****************************************************************/
+
+uint32_t history::drop_leaf(uint32_t i){
+    while(nodes[i].first_child != NONE){
+        uint32_t c = nodes[i].first_child;
+        if(c == nodes[i].active){
+            c = nodes[c].next; // c itself if it is the only child
+        }//if
+        i = c;
+    }//while
+    uint32_t p = nodes[i].parent;
+    unlink(i);
+    free_subtree(i);
+    return p;
+}//drop_leaf
+
+/*****************************************************************/
+
+void history::trim(){
+    /* once the current entry is the root, entries are forgotten from the
+     * leaves up; each search for a leaf starts where the last one ended,
+     * so that all of them together visit every entry only once */
+    uint32_t from = root;
+    while((live_nodes > max_entries || memory() > max_bytes)
+          && live_nodes > 1){
+        if(cur != root){
+            drop_root();
+            from = root;
+        }else{
+            from = drop_leaf(from);
+        }//else
+    }//while
+}//trim
+
+/*****************************************************************/
+
+void history::resize(size_t capacity, size_t budget){
+    max_entries = capacity;
+    max_bytes = budget;
+    trim();
+}//resize
+
+/*****************************************************************/
+
+void history::push(const core_state &C){
+    uint64_t d[core_state::MAX_DELTA_WORDS];
+    uint32_t i = new_node(C.delta(current, d), d);
+
+    /* new_node may have moved the nodes */
+    node &N = nodes[i];
+    node &P = nodes[cur];
+    N.parent = cur;
+    if(P.first_child == NONE){
+        P.first_child = i;
+    }else{
+        N.next = P.first_child;
+        N.prev = nodes[P.first_child].prev;
+        nodes[N.prev].next = i;
+        nodes[N.next].prev = i;
+    }//else
+    P.active = i;
+    cur = i;
+    current = C;
+
+    trim();
+}//push
+
+/*****************************************************************/
+
+bool history::undo(core_state &C){
+    if(cur == root){
+        return false;
+    }//if
+    apply(cur);
+    cur = nodes[cur].parent;
+    C = current;
+    return true;
+}//undo
+
+/*****************************************************************/
+
+bool history::redo(core_state &C){
+    if(nodes[cur].active == NONE){
+        return false;
+    }//if
+    cur = nodes[cur].active;
+    apply(cur);
+    C = current;
+    return true;
+}//redo
+
+/*****************************************************************/
+
+bool history::switch_branch(bool forward, core_state &C){
+    if(nodes[cur].next == cur){
+        return false;
+    }//if
+    uint32_t s = forward ? nodes[cur].next : nodes[cur].prev;
+    apply(cur);
+    apply(s);
+    nodes[nodes[cur].parent].active = s;
+    cur = s;
+    C = current;
+    return true;
+}//switch_branch
+
+/*****************************************************************/
+
+size_t history::entries(vector<entry> &E) const{
+    vector<uint32_t> path;
+    for(uint32_t i = cur; i != NONE; i = nodes[i].parent){
+        path.push_back(i);
+    }//for
+    reverse(path.begin(), path.end());
+    size_t position = path.size() - 1;
+    for(uint32_t i = nodes[cur].active; i != NONE; i = nodes[i].active){
+        path.push_back(i);
+    }//for
+
+    E.resize(path.size());
+    E[position].state = current;
+    for(size_t i = position; i > 0; i--){
+        E[i - 1].state = E[i].state;
+        E[i - 1].state.apply_delta(nodes[path[i]].parts,
+                                   words.data() + nodes[path[i]].offset);
+    }//for
+    for(size_t i = position + 1; i < path.size(); i++){
+        E[i].state = E[i - 1].state;
+        E[i].state.apply_delta(nodes[path[i]].parts,
+                               words.data() + nodes[path[i]].offset);
+    }//for
+
+    for(size_t i = 0; i < path.size(); i++){
+        uint32_t j = path[i];
+        E[i].branch = E[i].branches = 1;
+        if(nodes[j].parent == NONE){
+            continue;
+        }//if
+        uint32_t first = nodes[nodes[j].parent].first_child;
+        for(uint32_t s = nodes[first].next; s != first; s = nodes[s].next){
+            E[i].branches++;
+        }//for
+        for(uint32_t s = first; s != j; s = nodes[s].next){
+            E[i].branch++;
+        }//for
+    }//for
+    return position;
+}//entries
+
+/* aczutro ************************************************************* end */
@@ -0,0 +1,119 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#include <limbs.hh>
+
+
+/*** namespace limbs functions *****************************************/
+
+uint16_t limbs::significant_bits(const uint64_t *a, uint8_t n){
+    for(uint8_t i = n; i > 0; i--){
+        if(a[i - 1]){
+            return i * LIMB_BITS - __builtin_clzll(a[i - 1]);
+        }//if
+    }//for
+    return 0;
+}//significant_bits
+
+/*****************************************************************/
+
+void limbs::truncate(uint64_t *a, uint8_t n, uint16_t bits){
+    uint8_t i = bits / LIMB_BITS;
+    if(i >= n){
+        return;
+    }//if
+    if(bits % LIMB_BITS){
+        a[i] &= (UINT64_C(1) << (bits % LIMB_BITS)) - 1;
+        i++;
+    }//if
+    for(; i < n; i++){
+        a[i] = 0;
+    }//for
+}//truncate
+
+/*****************************************************************/
+
+void limbs::xor_range(uint64_t *a, uint16_t lo, uint16_t hi){
+    for(uint8_t i = lo / LIMB_BITS; i <= hi / LIMB_BITS; i++){
+        a[i] ^= range_mask(i, lo, hi);
+    }//for
+}//xor_range
+
+/*****************************************************************/
+
+void limbs::deposit(uint64_t *a, uint16_t lo, uint16_t hi,
+                    const uint64_t *b, uint8_t n){
+    for(uint8_t i = lo / LIMB_BITS; i <= hi / LIMB_BITS; i++){
+        uint64_t mask = range_mask(i, lo, hi);
+        uint8_t  tz   = __builtin_ctzll(mask);
+        uint64_t bits = window(b, n, i * LIMB_BITS + tz - lo);
+#ifdef __BMI2__
+        a[i] = (a[i] & ~mask) | _pdep_u64(bits, mask);
+#else
+        a[i] = (a[i] & ~mask) | ((bits << tz) & mask);
+#endif
+    }//for
+}//deposit
+
+/*****************************************************************/
+
+void limbs::extract(const uint64_t *a, uint8_t n, uint16_t lo, uint16_t hi,
+                    uint64_t *b){
+    uint16_t width = hi - lo + 1;
+    for(uint8_t i = 0; i < n; i++){
+        if(i * LIMB_BITS >= width){
+            b[i] = 0;
+        }else{
+            b[i] = window(a, n, lo + i * LIMB_BITS);
+        }//else
+    }//for
+    truncate(b, n, width);
+}//extract
+
+/*****************************************************************/
+
+uint64_t limbs::mul_add(uint64_t *a, uint8_t n, uint64_t m, uint64_t c){
+    for(uint8_t i = 0; i < n; i++){
+        unsigned __int128 product = (unsigned __int128)a[i] * m + c;
+        a[i] = (uint64_t)product;
+        c = (uint64_t)(product >> LIMB_BITS);
+    }//for
+    return c;
+}//mul_add
+
+/*****************************************************************/
+
+uint64_t limbs::div_mod(uint64_t *a, uint8_t n, uint64_t d){
+    unsigned __int128 r = 0;
+    for(uint8_t i = n; i > 0; i--){
+        r = (r << LIMB_BITS) | a[i - 1];
+        a[i - 1] = (uint64_t)(r / d);
+        r %= d;
+    }//for
+    return (uint64_t)r;
+}//div_mod
+
+/* aczutro ************************************************************* end */
@@ -0,0 +1,167 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#include <algorithm>
+#include <cstring>
+
+#include <name-index.hh>
+
+using namespace std;
+
+
+/*** static functions ********************************************************/
+
+/* returns true if the NUL-terminated name a matches glob pattern p..end-1,
+ * in which '*' stands for any sequence of characters */
+static bool matches(const char *a, const char *p, const char *end){
+    const char *star = NULL, *resume = NULL;
+    while(*a){
+        if(p < end && *p == '*'){
+            star = ++p;
+            resume = a;
+        }else if(p < end && *p == *a){
+            p++;
+            a++;
+        }else if(star){
+            p = star;
+            a = ++resume;
+        }else{
+            return false;
+        }//else
+    }//while
+    while(p < end && *p == '*'){
+        p++;
+    }//while
+    return p == end;
+}//matches
+
+
+/*** class name_index functions **********************************************/
+
+name_index::name_index(const vector<string> &entries,
+                       const vector<string> &names) : entries(entries){
+    vector<uint32_t> order(entries.size());
+    for(uint32_t i = 0; i < order.size(); i++){
+        order[i] = i;
+    }//for
+    sort(order.begin(), order.end(), [&](uint32_t i, uint32_t j){
+            return names[i] < names[j];
+        });
+
+    first_entry.push_back(0);
+    for(uint32_t i = 0; i < order.size(); i++){
+        const string &name = names[order[i]];
+        if(i == 0 || name != names[order[i - 1]]){
+            if(i){
+                first_entry.push_back(entry_ids.size());
+            }//if
+            starts.push_back(text.size());
+            text.insert(text.end(), name.begin(), name.end());
+            text.push_back('\0');
+        }//if
+        entry_ids.push_back(order[i]);
+    }//for
+    first_entry.push_back(entry_ids.size());
+
+    /* suffixes compare up to the end of their name only */
+    for(uint32_t i = 0; i < text.size(); i++){
+        if(text[i]){
+            suffixes.push_back(i);
+        }//if
+    }//for
+    const char *T = text.data();
+    sort(suffixes.begin(), suffixes.end(), [T](uint32_t i, uint32_t j){
+            return strcmp(T + i, T + j) < 0;
+        });
+}//name_index
+
+/*****************************************************************/
+
+vector<uint32_t> name_index::containing(const char *a, size_t length) const{
+    const char *T = text.data();
+    auto lo = lower_bound(suffixes.begin(), suffixes.end(), a,
+                          [T, length](uint32_t i, const char *b){
+                              return strncmp(T + i, b, length) < 0;
+                          });
+    auto hi = upper_bound(lo, suffixes.end(), a,
+                          [T, length](const char *b, uint32_t i){
+                              return strncmp(b, T + i, length) < 0;
+                          });
+
+    vector<uint32_t> response;
+    for(auto s = lo; s != hi; s++){
+        response.push_back(upper_bound(starts.begin(), starts.end(), *s)
+                           - starts.begin() - 1);
+    }//for
+    sort(response.begin(), response.end());
+    response.erase(unique(response.begin(), response.end()), response.end());
+    return response;
+}//containing
+
+/*****************************************************************/
+
+vector<string> name_index::find(const string &pattern) const{
+    string glob = pattern;
+    if(glob.find('*') == string::npos){
+        glob = "*" + glob + "*";
+    }//if
+
+    /* the longest piece without '*' narrows the search to the names that
+     * contain it */
+    size_t best = 0, best_length = 0;
+    for(size_t i = 0; i < glob.length(); ){
+        size_t j = glob.find('*', i);
+        if(j == string::npos){
+            j = glob.length();
+        }//if
+        if(j - i > best_length){
+            best = i;
+            best_length = j - i;
+        }//if
+        i = j + 1;
+    }//for
+
+    vector<uint32_t> candidates;
+    if(best_length){
+        candidates = containing(glob.c_str() + best, best_length);
+    }else{
+        candidates.resize(starts.size());
+        for(uint32_t i = 0; i < candidates.size(); i++){
+            candidates[i] = i;
+        }//for
+    }//else
+
+    vector<string> response;
+    for(uint32_t i : candidates){
+        if(! matches(text.data() + starts[i], glob.c_str(),
+                     glob.c_str() + glob.length())){
+            continue;
+        }//if
+        for(uint32_t j = first_entry[i]; j < first_entry[i + 1]; j++){
+            response.push_back(entries[entry_ids[j]]);
+        }//for
+    }//for
+    sort(response.begin(), response.end());
+    return response;
+}//find
+
+/* aczutro ************************************************************* end */
@@ -20,179 +20,401 @@
  *
  ******************************************************************* aczutro */
 
-#include <iostream>
-#include <fstream>
-
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <thread>
+
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <reg-info.hh>
 
 using namespace std;
 
 
-/*** macros ************************************************************/
+/*** static functions ********************************************************/
 
-#define BUFFER_SIZE 1000
+/* Appends path to files if it is not a directory; otherwise appends the spec
+ * files in it. */
+static void expand(const string &path, vector<string> &files){
+    struct stat st;
+    if(stat(path.c_str(), &st) || ! S_ISDIR(st.st_mode)){
+        files.push_back(path); // spec_file reports if it cannot be read
+        return;
+    }//if
 
-#define delete_config()  {config->close(); delete config;}
+    DIR *D = opendir(path.c_str());
+    if(! D){
+        throw(reg_info_exception({"cannot open directory '", path.c_str(),
+                        "'"}));
+    }//if
+    vector<string> names;
+    size_t suffix = strlen(spec_file::IMAGE_SUFFIX);
+    for(struct dirent *d; (d = readdir(D)) != NULL; ){
+        size_t length = strlen(d->d_name);
+        if(d->d_name[0] == '.'
+           || (length >= suffix && ! strcmp(d->d_name + length - suffix,
+                                            spec_file::IMAGE_SUFFIX))){
+            continue;
+        }//if
+        names.push_back(d->d_name);
+    }//for
+    closedir(D);
+    sort(names.begin(), names.end());
 
-/*** class reg_info functions ******************************************/
+    size_t before = files.size();
+    for(const string &name : names){
+        expand(path + "/" + name, files);
+    }//for
+    if(files.size() == before){
+        throw(reg_info_exception({"no spec files in '", path.c_str(), "'"}));
+    }//if
+}//expand
 
 
-reg_info::reg_info(const char *filename){
-    ifstream *config = new ifstream(filename);
-    if(! config || ! *config){
-        throw(reg_info_exception({"cannot open file '", filename, "'"}));
+/*** class reg_info functions ************************************************/
+
+reg_info::reg_info(const vector<string> &paths, unsigned jobs,
+                   bool use_image){
+    watch_fd = -1;
+    index = NULL;
+    vector<string> filenames;
+    for(const string &path : paths){
+        expand(path, filenames);
+    }//for
+    if(filenames.empty()){
+        throw(reg_info_exception("no spec files given"));
     }//if
 
-    __RD = new register_collection;
+    /* each thread takes the next file not taken yet; errors are reported
+     * for the first failing file in command line order */
+    files.assign(filenames.size(), NULL);
+    vector<string> errors(filenames.size());
+    atomic<size_t> next(0);
+    auto work = [&](){
+        for(size_t i; (i = next++) < filenames.size(); ){
+            try{
+                files[i] = new spec_file(filenames[i].c_str(), use_image);
+            }//try
+            catch(exception &e){
+                errors[i] = e.what();
+            }//catch
+        }//for
+    };
+    vector<thread> threads;
+    for(size_t i = 1; i < min<size_t>(jobs, filenames.size()); i++){
+        threads.emplace_back(work);
+    }//for
+    work();
+    for(thread &T : threads){
+        T.join();
+    }//for
+
+    for(const string &error : errors){
+        if(! error.empty()){
+            for(spec_file *S : files){
+                delete S;
+            }//for
+            throw(reg_info_exception(error));
+        }//if
+    }//for
+
     __max_number_of_fields = 0;
+    for(spec_file *S : files){
+        __max_number_of_fields = max(__max_number_of_fields,
+                                     S->max_number_of_fields());
+    }//for
+    if(files.size() > 1){
+        merge();
+    }//if
+}//reg_info
+
+/*****************************************************************/
+
+reg_info::~reg_info(){
+    unwatch();
+    delete index;
+    for(spec_file *S : files){
+        delete S;
+    }//for
+}//~reg_info
 
-    uint8_t num;
-    string name;
-    char buffer[BUFFER_SIZE];
-    char *token;
-    field_data *current = NULL;
-    field_data *first = NULL;
-    uint8_t field_counter = 0;
-    bool group_started = false;
-    char line[6];
-    uint16_t l = 0;
-    goto starting_point;
-    while(! config->eof()){
-        if(buffer[0] && buffer[0] != '#'){ // ignore lines starting with #
-            token = strtok(buffer, " \t");
-            if((! token) || token[0] == '#'){ // line is empty
-                goto starting_point;
+/*****************************************************************/
+
+void reg_info::merge(){
+    size_t total = 0;
+    for(spec_file *S : files){
+        total += S->number_of_registers();
+    }//for
+    uint32_t number_of_buckets = 64;
+    while(number_of_buckets < 2 * total){
+        number_of_buckets *= 2;
+    }//while
+    buckets.assign(number_of_buckets, 0);
+    entries.clear();
+    entries.reserve(total);
+    __warnings.clear();
+
+    for(uint32_t f = 0; f < files.size(); f++){
+        for(uint32_t r = 0; r < files[f]->number_of_registers(); r++){
+            const char *a = files[f]->name(files[f]->register_at(r).name);
+            uint32_t &b = bucket(a, strlen(a));
+            if(! b){
+                entries.push_back({f, r});
+                b = entries.size();
+                continue;
             }//if
-            for(char *ch = token; *ch; ch++){
-                if(! isdigit(*ch)){
-                    delete_config();
-                    delete_RD();
-                    throw(reg_info_exception({filename, ":", line, ": ",
-                                    "expected a positive number, but read '",
-                                    token, "'"}));
+            entry &E = entries[b - 1];
+            __warnings.push_back("register '" + string(a) + "' of '"
+                                 + files[f]->filename() + "' overrides the "
+                                 "one of '" + files[E.file]->filename()
+                                 + "'");
+            E = {f, r};
+        }//for
+    }//for
+}//merge
+
+/*****************************************************************/
+
+uint32_t &reg_info::bucket(const char *a, size_t length){
+    uint32_t mask = buckets.size() - 1;
+    for(uint32_t i = spec_file::name_hash(a, length) & mask; true;
+        i = (i + 1) & mask){
+        if(! buckets[i]){
+            return buckets[i];
+        }//if
+        const char *b = name(entries[buckets[i] - 1]);
+        if(! strncmp(a, b, length) && ! b[length]){
+            return buckets[i];
+        }//if
+    }//for
+}//bucket
+
+/*****************************************************************/
+
+void reg_info::save_images(){
+    for(spec_file *S : files){
+        S->save_image();
+    }//for
+}//save_images
+
+/*****************************************************************/
+
+void reg_info::watch(){
+    if(watch_fd >= 0){
+        return;
+    }//if
+    watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(watch_fd < 0){
+        throw(reg_info_exception("cannot watch spec files"));
+    }//if
+    watches.clear();
+    for(spec_file *S : files){
+        size_t slash = S->filename().rfind('/');
+        string directory = slash == string::npos ? string(".")
+            : S->filename().substr(0, slash ? slash : 1);
+        int wd = inotify_add_watch(watch_fd, directory.c_str(),
+                                   IN_CLOSE_WRITE | IN_MOVED_TO);
+        if(wd < 0){
+            unwatch();
+            throw(reg_info_exception({"cannot watch directory '",
+                            directory.c_str(), "'"}));
+        }//if
+        watches.push_back(wd);
+        S->keep_snapshot();
+    }//for
+}//watch
+
+/*****************************************************************/
+
+void reg_info::unwatch(){
+    if(watch_fd >= 0){
+        close(watch_fd);
+        watch_fd = -1;
+    }//if
+}//unwatch
+
+/*****************************************************************/
+
+void reg_info::refresh(vector<string> &reports, vector<string> &warnings,
+                       vector<string> &errors){
+    if(watch_fd < 0){
+        return;
+    }//if
+
+    vector<bool> changed(files.size(), false);
+    alignas(struct inotify_event) char buffer[4096];
+    for(ssize_t n; (n = read(watch_fd, buffer, sizeof(buffer))) > 0; ){
+        const struct inotify_event *E;
+        for(char *a = buffer; a < buffer + n; a += sizeof(*E) + E->len){
+            E = (const struct inotify_event*)a;
+            for(uint32_t i = 0; i < files.size(); i++){
+                if(E->mask & IN_Q_OVERFLOW){
+                    changed[i] = true;
+                    continue;
+                }//if
+                const string &filename = files[i]->filename();
+                size_t slash = filename.rfind('/');
+                const char *base = filename.c_str()
+                    + (slash == string::npos ? 0 : slash + 1);
+                if(E->wd == watches[i] && E->len && ! strcmp(E->name, base)){
+                    changed[i] = true;
                 }//if
             }//for
-            num = atoi(token);
-            if(num == 0){
-                if(group_started){
-                    token = strtok(NULL, " \t");
-                    if(token && token[0] != '#'){
-                        // if there is more on the line and it's not a comment
-                        delete_config();
-                        delete_RD();
-                        throw(reg_info_exception({filename, ":", line, ": ",
-                                        "unexpected token '", token, "'"}));
-                    }//if
-                    // close group
-                    if(first->width % 4){
-                        delete_config();
-                        delete_RD();
-                        throw(reg_info_exception({filename, ":", line, ": ",
-                                        "total width of register ",
-                                        first->name.c_str(),
-                                        " (", to_string(first->width).c_str(),
-                                        ") is not divisible by 4"}));
-                    }//if
-                    group_started = false;
-                    if(field_counter > __max_number_of_fields){
-                        __max_number_of_fields = field_counter;
-                    }//if
-                }else{
-                    token = strtok(NULL, " \t");
-                    if((! token) || token[0] == '#'){
-                        // if register name is not present
-                        delete_config();
-                        delete_RD();
-                        throw(reg_info_exception({filename, ":", line, ": ",
-                                        " expected register name"}));
-                    }else{
-                        // open group
-                        group_started = true;
-                        current = new field_data;
-                        memory_to_free.push(current);
-                        first = current;
-                        current->name = token;
-                        (*__RD)[token] = current;
-                        field_counter = 0;
-                    }//else
-                    token = strtok(NULL, " \t");
-                    if(token && token[0] != '#'){
-                        // if there is more on the line and it's not a comment
-                        delete_config();
-                        delete_RD();
-                        throw(reg_info_exception({filename, ":", line, ": ",
-                                        " unexpected token '", token, "'"}));
-                    }//if
-                }//else
-            }else{ // num is the width of a bit field
-                if(group_started){
-                    token = strtok(NULL, " \t");
-                    if((! token) || token[0] != '#'){
-                        // new field / new unused block
-                        current->next = new field_data;
-                        memory_to_free.push(current->next);
-                        current = current->next;
-                        current->width = num;
-                        if(token){
-                            current->name = token;
-                        }//if
-                        first->width += num;
-                        field_counter++;
-                    }else{ // i.e. token[0] == '#'
-                        delete_config();
-                        delete_RD();
-                        throw(reg_info_exception({filename, ":", line, ": ",
-                                        " expected field name"}));
-                    }//else
-                    token = strtok(NULL, " \t");
-                    if(token && token[0] != '#'){
-                        // if there is more on the line and it's not a comment
-                        delete_config();
-                        delete_RD();
-                        throw(reg_info_exception({filename, ":", line, ": ",
-                                        " unexpected token '", token, "'"}));
-                    }//if
-                }else{
-                    // field definition not expected because register name
-                    // hasn't been declared yet
-                    delete_config();
-                    delete_RD();
-                    throw(reg_info_exception({filename, ":", line, ": ",
-                                    "expected new register declaration starting with 0"}));
-                }//else
+        }//for
+    }//for
+
+    bool reloaded = false;
+    for(uint32_t i = 0; i < files.size(); i++){
+        if(! changed[i]){
+            continue;
+        }//if
+        const string &filename = files[i]->filename();
+        try{
+            uint32_t removed, parsed;
+            if(files[i]->reload(removed, parsed)){
+                if(removed || parsed){
+                    reports.push_back("'" + filename + "' changed; "
+                                      + to_string(parsed)
+                                      + " register definitions parsed again");
+                }//if
+            }else{
+                spec_file *S = new spec_file(filename.c_str(), false);
+                S->keep_snapshot();
+                delete files[i];
+                files[i] = S;
+                reports.push_back("'" + filename + "' changed; read again");
             }//else
+            reloaded = true;
+        }//try
+        catch(exception &e){
+            errors.push_back(e.what());
+        }//catch
+    }//for
+
+    if(reloaded){
+        delete index;
+        index = NULL;
+        sorted_names.clear();
+        __max_number_of_fields = 0;
+        for(spec_file *S : files){
+            __max_number_of_fields = max(__max_number_of_fields,
+                                         S->max_number_of_fields());
+        }//for
+        if(files.size() > 1){
+            vector<string> before;
+            before.swap(__warnings);
+            merge();
+            for(const string &warning : __warnings){
+                if(std::find(before.begin(), before.end(), warning)
+                   == before.end()){
+                    warnings.push_back(warning);
+                }//if
+            }//for
         }//if
-    starting_point:
-        l++;
-        sprintf(line, "%d", l);
-        config->getline(buffer, BUFFER_SIZE);
-    }//while
+    }//if
+}//refresh
 
-    if(group_started){
-        delete_config();
-        delete_RD();
-        throw(reg_info_exception({filename, ": ", "unexpected end of file; ",
-                        "last register definition is incomplete"}));
-    }//
+/*****************************************************************/
 
-    delete_config();
-}//reg_info
+register_ref reg_info::find(const string &regname){
+    if(files.size() == 1){
+        const register_layout *L = files[0]->layout(regname);
+        return {L ? files[0] : NULL, L};
+    }//if
+    uint32_t b = bucket(regname.c_str(), regname.length());
+    if(! b){
+        return {NULL, NULL};
+    }//if
+    const entry &E = entries[b - 1];
+    return {files[E.file], files[E.file]->layout_at(E.reg)};
+}//find
 
 /*****************************************************************/
 
-void reg_info::delete_RD(){
-    while(memory_to_free.size()){
-        delete memory_to_free.front();
-        memory_to_free.pop();
-    }//while
-    delete __RD;
-}//delete_RD
+register_ref reg_info::register_at(uint32_t i){
+    if(files.size() == 1){
+        return {files[0], files[0]->layout_at(i)};
+    }//if
+    const entry &E = entries[i];
+    return {files[E.file], files[E.file]->layout_at(E.reg)};
+}//register_at
+
+/*****************************************************************/
 
+vector<string> reg_info::search(const string &pattern){
+    if(! index){
+        vector<string> entries, names;
+        for(uint32_t i = 0; i < number_of_registers(); i++){
+            string regname = register_name(i);
+            entries.push_back(regname);
+            names.push_back(regname);
+            register_ref R;
+            try{
+                R = register_at(i);
+            }//try
+            catch(reg_info_exception&){
+                continue;
+            }//catch
+            const field_extractor *F = R.file->fields_of(*R.layout);
+            for(uint32_t j = 0; j < R.layout->number_of_fields; j++){
+                const char *fieldname = R.file->name(F[j].name);
+                entries.push_back(regname + "." + fieldname);
+                names.push_back(fieldname);
+            }//for
+        }//for
+        index = new name_index(entries, names);
+    }//if
+    return index->find(pattern);
+}//search
 
-reg_info::~reg_info(){
-    delete_RD();
-}//~reg_info
+/*****************************************************************/
+
+vector<string> reg_info::complete(const string &prefix){
+    if(sorted_names.empty()){
+        for(uint32_t i = 0; i < number_of_registers(); i++){
+            sorted_names.push_back(register_name(i));
+        }//for
+        sort(sorted_names.begin(), sorted_names.end());
+    }//if
+    auto a = lower_bound(sorted_names.begin(), sorted_names.end(), prefix);
+    vector<string> response;
+    for(; a != sorted_names.end()
+            && ! a->compare(0, prefix.length(), prefix); a++){
+        response.push_back(*a);
+    }//for
+    return response;
+}//complete
+
+/*****************************************************************/
+
+uint32_t reg_info::number_of_registers() const{
+    if(files.size() == 1){
+        return files[0]->number_of_registers();
+    }//if
+    return entries.size();
+}//number_of_registers
+
+/*****************************************************************/
+
+const char *reg_info::register_name(uint32_t i) const{
+    if(files.size() == 1){
+        return files[0]->name(files[0]->register_at(i).name);
+    }//if
+    return name(entries[i]);
+}//register_name
+
+/*****************************************************************/
+
+register_ref reg_info::register_header(uint32_t i) const{
+    if(files.size() == 1){
+        return {files[0], &files[0]->register_at(i)};
+    }//if
+    const entry &E = entries[i];
+    return {files[E.file], &files[E.file]->register_at(E.reg)};
+}//register_header
 
 /* aczutro ************************************************************* end */
@@ -0,0 +1,172 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#include <algorithm>
+#include <cstring>
+
+#include <exceptions.hh>
+#include <core-state.hh>
+#include <limbs.hh>
+#include <reserved-check.hh>
+
+using namespace std;
+using namespace exceptions;
+
+
+/*** macros ************************************************************/
+
+#define MAX_NUMBER_OF_BITS core_state::MAX_NUMBER_OF_BITS
+
+
+/*** class reserved_check functions ************************************/
+
+reserved_check::reserved_check(reg_info *RI){
+    vector<register_ref> R;
+    for(uint32_t i = 0; i < RI->number_of_registers(); i++){
+        register_ref r = RI->register_header(i);
+        if(r.layout->width && r.layout->width <= MAX_NUMBER_OF_BITS){
+            R.push_back(r);
+        }//if
+    }//for
+    build(R);
+}//reserved_check
+
+/*****************************************************************/
+
+reserved_check::reserved_check(reg_info *RI, const string &regname){
+    register_ref r = RI->find(regname);
+    if(! r.layout){
+        throw(UNKNOWN_REG_DEF);
+    }//if
+    if(r.layout->width > MAX_NUMBER_OF_BITS){
+        throw(UNSUPPORTED_WIDTH);
+    }//if
+    vector<register_ref> R(1, r);
+    build(R);
+}//reserved_check
+
+/*****************************************************************/
+
+void reserved_check::build(vector<register_ref> &R){
+    sort(R.begin(), R.end(), [](const register_ref &a, const register_ref &b){
+            if(a.layout->width != b.layout->width){
+                return a.layout->width < b.layout->width;
+            }//if
+            return strcmp(a.file->name(a.layout->name),
+                          b.file->name(b.layout->name)) < 0;
+        });
+
+    groups.assign(MAX_NUMBER_OF_BITS / 4 + 1, {0, 0, 0});
+    for(uint32_t i = 0; i < R.size(); ){
+        uint16_t width = R[i].layout->width;
+        uint8_t n = (width + limbs::LIMB_BITS - 1) / limbs::LIMB_BITS;
+        group &G = groups[width / 4];
+        G.first = i;
+        G.offset = masks.size();
+        for(; i < R.size() && R[i].layout->width == width; i++){
+            names.push_back(R[i].file->name(R[i].layout->name));
+            widths.push_back(width);
+        }//for
+        G.count = i - G.first;
+        masks.resize(masks.size() + n * G.count);
+        for(uint32_t j = 0; j < G.count; j++){
+            const register_ref &r = R[G.first + j];
+            const uint64_t *M = r.file->reserved_mask(*r.layout);
+            for(uint8_t l = 0; l < n; l++){
+                masks[G.offset + l * G.count + j] = M[l];
+            }//for
+        }//for
+    }//for
+}//build
+
+/*****************************************************************/
+
+uint32_t reserved_check::number_of_registers(uint16_t number_of_bits) const{
+    if(number_of_bits > MAX_NUMBER_OF_BITS || number_of_bits % 4){
+        return 0;
+    }//if
+    return groups[number_of_bits / 4].count;
+}//number_of_registers
+
+/*****************************************************************/
+
+void reserved_check::check(const uint64_t *value, uint16_t number_of_bits,
+                           vector<uint32_t> &violations,
+                           vector<uint64_t> &hits) const{
+    uint32_t count = number_of_registers(number_of_bits);
+    if(! count){
+        return;
+    }//if
+    const group &G = groups[number_of_bits / 4];
+    hits.assign(count, 0);
+    uint64_t *H = hits.data();
+    uint8_t n = (number_of_bits + limbs::LIMB_BITS - 1) / limbs::LIMB_BITS;
+    for(uint8_t l = 0; l < n; l++){
+        uint64_t v = value[l];
+        if(! v){
+            continue;
+        }//if
+        const uint64_t *M = masks.data() + G.offset + l * count;
+        for(uint32_t j = 0; j < count; j++){
+            H[j] |= v & M[j];
+        }//for
+    }//for
+    for(uint32_t j = 0; j < count; j++){
+        if(H[j]){
+            violations.push_back(G.first + j);
+        }//if
+    }//for
+}//check
+
+/*****************************************************************/
+
+string reserved_check::set_bits(const uint64_t *value, uint32_t i) const{
+    const group &G = groups[widths[i] / 4];
+    uint8_t n = (widths[i] + limbs::LIMB_BITS - 1) / limbs::LIMB_BITS;
+    uint64_t set[core_state::MAX_LIMBS];
+    for(uint8_t l = 0; l < n; l++){
+        set[l] = value[l] & masks[G.offset + l * G.count + i - G.first];
+    }//for
+
+    string response;
+    for(int32_t hi = widths[i] - 1; hi >= 0; hi--){
+        if(! limbs::bit(set, hi)){
+            continue;
+        }//if
+        int32_t lo = hi;
+        while(lo > 0 && limbs::bit(set, lo - 1)){
+            lo--;
+        }//while
+        if(! response.empty()){
+            response.push_back(' ');
+        }//if
+        response += "[" + to_string(hi);
+        if(lo < hi){
+            response += ".." + to_string(lo);
+        }//if
+        response += "]";
+        hi = lo;
+    }//for
+    return response;
+}//set_bits
+
+/* aczutro ************************************************************* end */
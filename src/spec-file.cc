@@ -0,0 +1,1201 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#include <algorithm>
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spec-file.hh>
+
+using namespace std;
+
+
+/*** macros ************************************************************/
+
+/* spec files that cannot be mapped are read in blocks of this size */
+#define READ_BLOCK_SIZE (1 << 16)
+
+#define is_blank(ch) ((ch) == ' ' || (ch) == '\t' || (ch) == '\r')
+
+/* Spec cache files start with an image_header, followed by the name table,
+ * the field table, the register table, the hash index, the value table and
+ * the mask table, each starting at a multiple of 8 bytes.  IMAGE_VERSION
+ * MUST be incremented whenever any of these structures changes. */
+#define IMAGE_MAGIC "hexcalc"
+#define IMAGE_VERSION 5
+
+/* of the FNV-1a hash of spec files and spec caches */
+#define FNV_BASIS UINT64_C(14695981039346656037)
+#define FNV_PRIME UINT64_C(1099511628211)
+
+#define align8(a) (((a) + 7) & ~(uint64_t)7)
+
+/* fields of up to this many bits get a dense value table */
+#define DENSE_VALUE_BITS 8
+
+/* the number of seeds tried per bucket of a hashed value table before it is
+ * made larger */
+#define MAX_SEEDS (1 << 16)
+
+
+/*** help functions and data types *************************************/
+
+struct image_header{
+    char     magic[8];
+    uint32_t version;
+    uint32_t sizes[3]; // of image_header, field_extractor, register_layout
+    int64_t  source_size;
+    int64_t  source_mtime[2];
+    uint64_t source_hash;
+    uint64_t image_hash; // of everything after the header
+    uint64_t names_offset;
+    uint64_t names_size;
+    uint64_t fields_offset;
+    uint64_t number_of_fields;
+    uint64_t registers_offset;
+    uint64_t number_of_registers;
+    uint64_t buckets_offset;
+    uint64_t number_of_buckets;
+    uint64_t values_offset;
+    uint64_t number_of_values;
+    uint64_t masks_offset;
+    uint64_t number_of_masks;
+    uint16_t max_number_of_fields;
+};
+
+/* returns true if a table of n elements of the given size, starting at
+ * offset, lies within an image of size bytes and is aligned to 8 bytes */
+static inline bool table_fits(uint64_t offset, uint64_t n, uint64_t size,
+                              uint64_t element_size){
+    return offset <= size && ! (offset % 8)
+        && n <= (size - offset) / element_size;
+}//table_fits
+
+/* returns true if entry i of a value table, 0 or a name offset plus 1, refers
+ * into a name table of names_size characters */
+static inline bool value_entry_fits(const uint32_t *values, uint64_t i,
+                                    uint64_t names_size){
+    return values[i] <= names_size;
+}//value_entry_fits
+
+/* Returns true if every offset within the tables of the image at map, whose
+ * header H has been checked already, refers into its table, so that a
+ * damaged or stale spec cache is never read beyond its tables. */
+static bool image_is_consistent(const image_header *H, const char *map){
+    const char *names = map + H->names_offset;
+    const field_extractor *fields
+        = (const field_extractor*)(map + H->fields_offset);
+    const register_layout *registers
+        = (const register_layout*)(map + H->registers_offset);
+    const uint32_t *buckets = (const uint32_t*)(map + H->buckets_offset);
+    const uint32_t *values = (const uint32_t*)(map + H->values_offset);
+
+    /* every name offset within the table refers to a NUL-terminated name */
+    if(H->names_size ? names[H->names_size - 1] != 0
+       : H->number_of_registers != 0){
+        return false;
+    }//if
+
+    for(uint64_t i = 0; i < H->number_of_registers; i++){
+        const register_layout &R = registers[i];
+        if(! R.parsed || R.name >= H->names_size
+           || (uint64_t)R.first_field + R.number_of_fields
+              > H->number_of_fields
+           || (uint64_t)R.reserved
+              + (R.width + limbs::LIMB_BITS - 1) / limbs::LIMB_BITS
+              > H->number_of_masks){
+            return false;
+        }//if
+        for(uint32_t j = 0; j < R.number_of_fields; j++){
+            const field_extractor &F = fields[R.first_field + j];
+            if((uint64_t)F.name + F.name_length >= H->names_size
+               || F.lo > F.hi || F.hi >= R.width
+               || F.limb != F.lo / limbs::LIMB_BITS
+               || F.shift != F.lo % limbs::LIMB_BITS){
+                return false;
+            }//if
+            uint64_t n;
+            switch(F.value_kind){
+            case NO_VALUE_NAMES:
+                continue;
+            case DENSE_VALUE_NAMES:
+                if(F.width() > DENSE_VALUE_BITS){
+                    return false;
+                }//if
+                n = UINT64_C(1) << F.width();
+                break;
+            case HASHED_VALUE_NAMES:
+                if(F.width() > limbs::LIMB_BITS
+                   || F.bucket_bits >= 32 || F.slot_bits >= 32){
+                    return false;
+                }//if
+                n = (UINT64_C(1) << F.bucket_bits)
+                    + 3 * (UINT64_C(1) << F.slot_bits);
+                break;
+            default:
+                return false;
+            }//switch
+            if((uint64_t)F.values + n > H->number_of_values){
+                return false;
+            }//if
+            if(F.value_kind == DENSE_VALUE_NAMES){
+                for(uint64_t k = 0; k < n; k++){
+                    if(! value_entry_fits(values, F.values + k,
+                                          H->names_size)){
+                        return false;
+                    }//if
+                }//for
+            }else{
+                uint64_t slots = F.values + (UINT64_C(1) << F.bucket_bits);
+                for(uint64_t k = slots + 2; k < F.values + n; k += 3){
+                    if(! value_entry_fits(values, k, H->names_size)){
+                        return false;
+                    }//if
+                }//for
+            }//else
+        }//for
+    }//for
+
+    /* the index must have an empty bucket for every probe to end */
+    uint64_t used = 0;
+    for(uint64_t i = 0; i < H->number_of_buckets; i++){
+        if(buckets[i] > H->number_of_registers){
+            return false;
+        }//if
+        used += buckets[i] != 0;
+    }//for
+    return used <= H->number_of_registers;
+}//image_is_consistent
+
+/* returns a hash (FNV-1a, 8 bytes at a time) of the characters from a up to,
+ * but not including, end */
+static uint64_t hash_bytes(const char *a, const char *end){
+    uint64_t response = FNV_BASIS;
+    for(uint64_t word; a + 8 <= end; a += 8){
+        memcpy(&word, a, 8);
+        response = (response ^ word) * FNV_PRIME;
+    }//for
+    for(; a < end; a++){
+        response = (response ^ (uint8_t)*a) * FNV_PRIME;
+    }//for
+    return response;
+}//hash_bytes
+
+/* returns a hash of the contents of the file filename (0 if it cannot be
+ * read) */
+static uint64_t content_hash(const char *filename){
+    uint64_t response = FNV_BASIS;
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st)){
+        if(fd >= 0){
+            close(fd);
+        }//if
+        return 0;
+    }//if
+    if(st.st_size){
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(map == MAP_FAILED){
+            close(fd);
+            return 0;
+        }//if
+        response = hash_bytes((const char*)map,
+                              (const char*)map + st.st_size);
+        munmap(map, st.st_size);
+    }//if
+    close(fd);
+    return response ^ st.st_size;
+}//content_hash
+
+/* Skips blanks from a on, and returns false if the line (which ends at eol)
+ * has no more tokens.  Otherwise, token and length are set to the next token
+ * and a points behind it. */
+inline static bool next_token(const char *&a, const char *eol,
+                              const char *&token, size_t &length){
+    while(a < eol && is_blank(*a)){
+        a++;
+    }//while
+    if(a == eol){
+        return false;
+    }//if
+    token = a;
+    while(a < eol && ! is_blank(*a)){
+        a++;
+    }//while
+    length = a - token;
+    return true;
+}//next_token
+
+/* Sets num to the value of the length decimal digits at token.  Returns
+ * false if token is not a number or doesn't fit into 16 bits. */
+static bool parse_number(const char *token, size_t length, uint16_t &num){
+    uint32_t value = 0;
+    for(const char *ch = token; ch < token + length; ch++){
+        if(*ch < '0' || *ch > '9'){
+            return false;
+        }//if
+        value = value * 10 + (*ch - '0');
+        if(value > UINT16_MAX){
+            return false;
+        }//if
+    }//for
+    num = value;
+    return true;
+}//parse_number
+
+/* Sets value to the number at token (length characters, decimal or
+ * hexadecimal with prefix 0x).  Returns false if token is not a number or
+ * doesn't fit into 64 bits. */
+static bool parse_value(const char *token, size_t length, uint64_t &value){
+    bool hex = length > 2 && token[0] == '0'
+        && (token[1] == 'x' || token[1] == 'X');
+    if(hex){
+        token += 2;
+        length -= 2;
+    }//if
+    if(! length){
+        return false;
+    }//if
+    unsigned __int128 response = 0;
+    for(const char *ch = token; ch < token + length; ch++){
+        int digit;
+        if(*ch >= '0' && *ch <= '9'){
+            digit = *ch - '0';
+        }else if(hex && *ch >= 'a' && *ch <= 'f'){
+            digit = *ch - 'a' + 10;
+        }else if(hex && *ch >= 'A' && *ch <= 'F'){
+            digit = *ch - 'A' + 10;
+        }else{
+            return false;
+        }//else
+        response = response * (hex ? 16 : 10) + digit;
+        if(response > UINT64_MAX){
+            return false;
+        }//if
+    }//for
+    value = response;
+    return true;
+}//parse_value
+
+/* returns the bucket of the register called a in the given tables */
+static uint32_t probe(const uint32_t *buckets, uint32_t number_of_buckets,
+                      const register_layout *registers, const char *names,
+                      const char *a, size_t length){
+    uint32_t mask = number_of_buckets - 1;
+    for(uint32_t i = spec_file::name_hash(a, length) & mask; true; i = (i + 1) & mask){
+        if(! buckets[i]){
+            return i;
+        }//if
+        const char *b = names + registers[buckets[i] - 1].name;
+        if(! strncmp(a, b, length) && ! b[length]){
+            return i;
+        }//if
+    }//for
+}//probe
+
+/* Builds the hash index buckets on the register table R.  A register that
+ * is defined more than once takes the place of its first definition.
+ * Returns the number of definitions dropped that way. */
+static uint32_t build_index(vector<register_layout> &R, const char *names,
+                            vector<uint32_t> &buckets){
+    uint32_t number_of_buckets = 64;
+    while(number_of_buckets < 2 * R.size()){
+        number_of_buckets *= 2;
+    }//while
+    buckets.assign(number_of_buckets, 0);
+
+    uint32_t n = 0;
+    for(uint32_t i = 0; i < R.size(); i++){
+        const char *a = names + R[i].name;
+        uint32_t &b = buckets[probe(buckets.data(), number_of_buckets,
+                                    R.data(), names, a, strlen(a))];
+        if(b){ // redefinition replaces earlier definition
+            R[b - 1] = R[i];
+        }else{
+            R[n] = R[i];
+            b = ++n;
+        }//else
+    }//for
+    uint32_t dropped = R.size() - n;
+    R.resize(n);
+    return dropped;
+}//build_index
+
+/* Reads the regular file fd (with status st) into text.  Returns false on
+ * errors. */
+static bool read_text(int fd, const struct stat &st, string &text){
+    text.resize(st.st_size);
+    for(off_t done = 0; done < st.st_size; ){
+        ssize_t n = pread(fd, &text[done], st.st_size - done, done);
+        if(n <= 0){
+            return false;
+        }//if
+        done += n;
+    }//for
+    return true;
+}//read_text
+
+/* returns the length of the longest common prefix of the n characters at a
+ * and the n characters at b */
+static size_t common_prefix(const char *a, const char *b, size_t n){
+    size_t i = 0;
+    while(i + READ_BLOCK_SIZE <= n && ! memcmp(a + i, b + i, READ_BLOCK_SIZE)){
+        i += READ_BLOCK_SIZE;
+    }//while
+    while(i < n && a[i] == b[i]){
+        i++;
+    }//while
+    return i;
+}//common_prefix
+
+/* returns the length of the longest common suffix of the n characters
+ * before a and the n characters before b */
+static size_t common_suffix(const char *a, const char *b, size_t n){
+    size_t i = 0;
+    while(i + READ_BLOCK_SIZE <= n
+          && ! memcmp(a - i - READ_BLOCK_SIZE, b - i - READ_BLOCK_SIZE,
+                      READ_BLOCK_SIZE)){
+        i += READ_BLOCK_SIZE;
+    }//while
+    while(i < n && a[-1 - (ssize_t)i] == b[-1 - (ssize_t)i]){
+        i++;
+    }//while
+    return i;
+}//common_suffix
+
+/*** class spec_file functions *****************************************/
+
+const char *const spec_file::IMAGE_SUFFIX = ".cache";
+
+/*****************************************************************/
+
+spec_file::spec_file(const char *filename, bool use_image){
+    image = NULL;
+    image_size = 0;
+    source_fd = -1;
+    source_name = filename;
+    redefinitions = false;
+    has_snapshot = false;
+    if(use_image && load_image(filename)){
+        return;
+    }//if
+
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st)){
+        if(fd >= 0){
+            close(fd);
+        }//if
+        throw(reg_info_exception({"cannot open file '", filename, "'"}));
+    }//if
+    source_size = st.st_size;
+    source_mtime[0] = st.st_mtim.tv_sec;
+    source_mtime[1] = st.st_mtim.tv_nsec;
+
+    /* regular files are mapped, anything else is read into buffer */
+    void *map = MAP_FAILED;
+    if(S_ISREG(st.st_mode) && st.st_size){
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }//if
+    string buffer;
+    const char *text;
+    size_t size;
+    if(map != MAP_FAILED){
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+        text = (const char*)map;
+        size = st.st_size;
+    }else{
+        char block[READ_BLOCK_SIZE];
+        for(ssize_t n; (n = read(fd, block, READ_BLOCK_SIZE)) != 0; ){
+            if(n < 0){
+                close(fd);
+                throw(reg_info_exception({"cannot read file '", filename,
+                                "'"}));
+            }//if
+            buffer.append(block, n);
+        }//for
+        text = buffer.data();
+        size = buffer.length();
+    }//else
+
+    try{
+        __max_number_of_fields = 0;
+        parse(text, text + size, 0, 0, registers);
+        redefinitions = build_index(registers, names.data(), buckets) > 0;
+        if(map == MAP_FAILED){
+            /* bodies cannot be read again later */
+            for(register_layout &R : registers){
+                parse_body(R, text + R.body, text + R.body + R.body_length);
+            }//for
+        }//if
+    }//try
+    catch(...){
+        if(map != MAP_FAILED){
+            munmap(map, st.st_size);
+        }//if
+        close(fd);
+        throw;
+    }//catch
+    if(map != MAP_FAILED){
+        munmap(map, st.st_size);
+        source_fd = fd;
+    }else{
+        close(fd);
+    }//else
+
+    __names = names.data();
+    __fields = fields.data();
+    __registers = registers.data();
+    __buckets = buckets.data();
+    __values = values.data();
+    __masks = masks.data();
+    __number_of_registers = registers.size();
+    __number_of_buckets = buckets.size();
+}//spec_file
+
+/*****************************************************************/
+
+#define parse_error(...)                                                \
+    throw(reg_info_exception({source_name.c_str(), ":",                 \
+                    to_string(l).c_str(), ": ", __VA_ARGS__}))
+
+void spec_file::parse(const char *a, const char *end, uint64_t base,
+                      size_t lines_before, vector<register_layout> &R){
+    const char *begin = a;
+    register_layout current;
+    uint16_t field_counter = 0;
+    bool group_started = false;
+    vector<pair<uint16_t, uint16_t>> unnamed; // offset from MSB, width
+    const char *token;
+    size_t length;
+    uint16_t num;
+    size_t l = lines_before;
+
+    for(const char *eol; a < end; a = eol + 1){
+        const char *line = a;
+        eol = (const char*)memchr(a, '\n', end - a);
+        if(! eol){
+            eol = end;
+        }//if
+        l++;
+        if(! next_token(a, eol, token, length) || token[0] == '#'){
+            continue; // line is empty or a comment
+        }//if
+        if(length == 1 && token[0] == '='){
+            if(! group_started){
+                parse_error("expected new register declaration starting with 0");
+            }//if
+            continue; // value names are read with the fields
+        }//if
+        if(! parse_number(token, length, num)){
+            parse_error("expected a positive number, but read '",
+                        string(token, length).c_str(), "'");
+        }//if
+
+        if(num == 0){
+            if(group_started){
+                if(next_token(a, eol, token, length) && token[0] != '#'){
+                    // if there is more on the line and it's not a comment
+                    parse_error("unexpected token '",
+                                string(token, length).c_str(), "'");
+                }//if
+                // close group
+                if(current.width % 4){
+                    parse_error("total width of register ",
+                                name(current.name),
+                                " (", to_string(current.width).c_str(),
+                                ") is not divisible by 4");
+                }//if
+                current.body_length = line - (begin + (current.body - base));
+                current.reserved = masks.size();
+                masks.resize(masks.size()
+                             + (current.width + limbs::LIMB_BITS - 1)
+                             / limbs::LIMB_BITS, 0);
+                /* every unnamed field ends within the register, as the
+                 * widths of all fields were added up to current.width
+                 * without exceeding UINT16_MAX */
+                for(const pair<uint16_t, uint16_t> &u : unnamed){
+                    uint32_t lo = current.width - u.first - u.second;
+                    for(uint32_t i = lo; i < lo + u.second; i++){
+                        masks[current.reserved + i / limbs::LIMB_BITS]
+                            |= UINT64_C(1) << (i % limbs::LIMB_BITS);
+                    }//for
+                }//for
+                R.push_back(current);
+                group_started = false;
+                if(field_counter > __max_number_of_fields){
+                    __max_number_of_fields = field_counter;
+                }//if
+            }else{
+                if(! next_token(a, eol, token, length) || token[0] == '#'){
+                    // if register name is not present
+                    parse_error(" expected register name");
+                }//if
+                // open group
+                group_started = true;
+                current.name = add_name(token, length);
+                current.first_field = 0;
+                current.number_of_fields = 0;
+                current.width = 0;
+                current.body = base + (eol + 1 - begin);
+                current.first_line = l + 1;
+                current.parsed = false;
+                field_counter = 0;
+                unnamed.clear();
+                if(next_token(a, eol, token, length) && token[0] != '#'){
+                    // if there is more on the line and it's not a comment
+                    parse_error(" unexpected token '",
+                                string(token, length).c_str(), "'");
+                }//if
+            }//else
+        }else{ // num is the width of a bit field
+            if(! group_started){
+                // field definition not expected because register name
+                // hasn't been declared yet
+                parse_error("expected new register declaration starting with 0");
+            }//if
+            if(current.width + num > UINT16_MAX){
+                parse_error("total width of register ", name(current.name),
+                            " exceeds ", to_string(UINT16_MAX).c_str(),
+                            " bits");
+            }//if
+            if(! next_token(a, eol, token, length) || token[0] == '#'){
+                unnamed.push_back({current.width, num});
+            }//if
+            current.width += num;
+            field_counter++;
+        }//else
+    }//for
+
+    if(group_started){
+        throw(reg_info_exception({source_name.c_str(), ": ",
+                        "unexpected end of file; ",
+                        "last register definition is incomplete"}));
+    }//if
+}//parse
+
+/*****************************************************************/
+
+void spec_file::parse_body(register_layout &R, const char *a, const char *end){
+    R.first_field = fields.size();
+    R.number_of_fields = 0;
+
+    uint16_t offset = 0; // from the MSB
+    const char *token;
+    size_t length;
+    uint16_t num;
+    size_t l = R.first_line - 1;
+
+    /* named values of the last field line, if it has a name */
+    vector<pair<uint64_t, uint32_t>> V;
+    int64_t named_field = -1;
+
+    for(const char *eol; a < end; a = eol + 1){
+        eol = (const char*)memchr(a, '\n', end - a);
+        if(! eol){
+            eol = end;
+        }//if
+        l++;
+        if(! next_token(a, eol, token, length) || token[0] == '#'){
+            continue; // line is empty or a comment
+        }//if
+        if(length == 1 && token[0] == '='){
+            if(named_field < 0){
+                parse_error("value name without a named field");
+            }//if
+            const field_extractor &F = fields[named_field];
+            uint64_t value;
+            if(! next_token(a, eol, token, length) || token[0] == '#'
+               || ! parse_value(token, length, value)){
+                parse_error(" expected value");
+            }//if
+            if(F.hi - F.lo + 1 > limbs::LIMB_BITS){
+                parse_error("field ", name(F.name), " is too wide for ",
+                            "value names");
+            }//if
+            if(F.hi - F.lo + 1 < limbs::LIMB_BITS
+               && value >> (F.hi - F.lo + 1)){
+                parse_error("value ", string(token, length).c_str(),
+                            " does not fit into field ", name(F.name));
+            }//if
+            for(const pair<uint64_t, uint32_t> &v : V){
+                if(v.first == value){
+                    parse_error("value ", string(token, length).c_str(),
+                                " of field ", name(F.name),
+                                " is named twice");
+                }//if
+            }//for
+            if(! next_token(a, eol, token, length) || token[0] == '#'){
+                parse_error(" expected value name");
+            }//if
+            V.push_back({value, add_name(token, length)});
+            if(next_token(a, eol, token, length) && token[0] != '#'){
+                // if there is more on the line and it's not a comment
+                parse_error(" unexpected token '",
+                            string(token, length).c_str(), "'");
+            }//if
+            continue;
+        }//if
+        if(named_field >= 0 && ! V.empty()){
+            add_values(fields[named_field], V);
+        }//if
+        named_field = -1;
+        if(! parse_number(token, length, num) || ! num){
+            parse_error("expected a positive number, but read '",
+                        string(token, length).c_str(), "'");
+        }//if
+        if(next_token(a, eol, token, length)){
+            if(token[0] == '#'){
+                parse_error(" expected field name");
+            }//if
+            field_extractor F;
+            F.name = add_name(token, length);
+            F.name_length = length;
+            F.lo = offset;
+            F.hi = offset + num - 1;
+            F.value_kind = NO_VALUE_NAMES;
+            F.bucket_bits = 0;
+            F.slot_bits = 0;
+            F.values = 0;
+            named_field = fields.size();
+            fields.push_back(F);
+            R.number_of_fields++;
+            if(next_token(a, eol, token, length) && token[0] != '#'){
+                // if there is more on the line and it's not a comment
+                parse_error(" unexpected token '",
+                            string(token, length).c_str(), "'");
+            }//if
+        }//if
+        offset += num;
+    }//for
+    if(named_field >= 0 && ! V.empty()){
+        add_values(fields[named_field], V);
+    }//if
+
+    compile(R);
+    R.parsed = true;
+    __fields = fields.data();
+    __values = values.data();
+}//parse_body
+
+/*****************************************************************/
+
+void spec_file::add_values(field_extractor &F,
+                           vector<pair<uint64_t, uint32_t>> &V){
+    F.values = values.size();
+    uint16_t width = F.hi - F.lo + 1;
+    if(width <= DENSE_VALUE_BITS){
+        F.value_kind = DENSE_VALUE_NAMES;
+        values.resize(values.size() + (1u << width), 0);
+        for(const pair<uint64_t, uint32_t> &v : V){
+            values[F.values + v.first] = v.second + 1;
+        }//for
+        V.clear();
+        return;
+    }//if
+
+    /* Hash and displace: the values are spread over buckets, and each
+     * bucket, largest first, gets the first seed that maps all its values
+     * to free slots. */
+    F.value_kind = HASHED_VALUE_NAMES;
+    F.bucket_bits = 0;
+    while((2u << F.bucket_bits) <= V.size()){
+        F.bucket_bits++;
+    }//while
+    F.slot_bits = F.bucket_bits + 1;
+    while(true){
+        uint32_t number_of_buckets = 1u << F.bucket_bits;
+        uint32_t number_of_slots = 1u << F.slot_bits;
+        vector<vector<uint32_t>> B(number_of_buckets);
+        for(uint32_t i = 0; i < V.size(); i++){
+            B[value_hash(V[i].first, 0) & (number_of_buckets - 1)]
+                .push_back(i);
+        }//for
+        vector<uint32_t> order(number_of_buckets);
+        for(uint32_t i = 0; i < number_of_buckets; i++){
+            order[i] = i;
+        }//for
+        stable_sort(order.begin(), order.end(),
+                    [&B](uint32_t a, uint32_t b){
+                        return B[a].size() > B[b].size();
+                    });
+
+        vector<uint32_t> seeds(number_of_buckets, 0);
+        vector<int64_t> slots(number_of_slots, -1);
+        vector<uint32_t> taken;
+        bool ok = true;
+        for(uint32_t b : order){
+            if(B[b].empty()){
+                break;
+            }//if
+            uint32_t seed;
+            for(seed = 1; seed < MAX_SEEDS; seed++){
+                taken.clear();
+                for(uint32_t i : B[b]){
+                    uint32_t slot = value_hash(V[i].first, seed)
+                        & (number_of_slots - 1);
+                    if(slots[slot] >= 0 || find(taken.begin(), taken.end(),
+                                                slot) != taken.end()){
+                        break;
+                    }//if
+                    taken.push_back(slot);
+                }//for
+                if(taken.size() == B[b].size()){
+                    break;
+                }//if
+            }//for
+            if(seed == MAX_SEEDS){
+                ok = false;
+                break;
+            }//if
+            seeds[b] = seed;
+            for(uint32_t i = 0; i < taken.size(); i++){
+                slots[taken[i]] = B[b][i];
+            }//for
+        }//for
+        if(! ok){
+            F.slot_bits++;
+            continue;
+        }//if
+
+        values.insert(values.end(), seeds.begin(), seeds.end());
+        for(int64_t i : slots){
+            if(i < 0){
+                /* a free slot matches no value: its name is 0 */
+                values.insert(values.end(), {0, 0, 0});
+            }else{
+                values.insert(values.end(),
+                              {(uint32_t)V[i].first,
+                               (uint32_t)(V[i].first >> 32),
+                               V[i].second + 1});
+            }//else
+        }//for
+        V.clear();
+        return;
+    }//while
+}//add_values
+
+/*****************************************************************/
+
+void spec_file::load_body(register_layout &R){
+    struct stat st;
+    if(fstat(source_fd, &st) || st.st_size != source_size
+       || st.st_mtim.tv_sec != source_mtime[0]
+       || st.st_mtim.tv_nsec != source_mtime[1]){
+        throw(reg_info_exception({"'", source_name.c_str(),
+                        "' has changed since it was read; load it again"}));
+    }//if
+    string buffer(R.body_length, 0);
+    if(pread(source_fd, &buffer[0], R.body_length, R.body)
+       != (ssize_t)R.body_length){
+        throw(reg_info_exception({"cannot read file '", source_name.c_str(),
+                        "'"}));
+    }//if
+    /* a body with an error leaves no fields or values behind, and the tables
+     * of the registers parsed so far where they are */
+    size_t number_of_fields = fields.size();
+    size_t number_of_values = values.size();
+    try{
+        parse_body(R, buffer.data(), buffer.data() + buffer.length());
+    }//try
+    catch(...){
+        fields.resize(number_of_fields);
+        values.resize(number_of_values);
+        R.first_field = 0;
+        R.number_of_fields = 0;
+        __fields = fields.data();
+        __values = values.data();
+        throw;
+    }//catch
+}//load_body
+
+#undef parse_error
+
+/*****************************************************************/
+
+spec_file::~spec_file(){
+    if(image){
+        munmap(image, image_size);
+    }//if
+    if(source_fd >= 0){
+        close(source_fd);
+    }//if
+}//~spec_file
+
+/*****************************************************************/
+
+bool spec_file::load_image(const char *filename){
+    struct stat source, st;
+    if(stat(filename, &source)){
+        return false;
+    }//if
+    string image_name = string(filename) + IMAGE_SUFFIX;
+    int fd = open(image_name.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }//if
+    if(fstat(fd, &st) || (size_t)st.st_size < sizeof(image_header)){
+        close(fd);
+        return false;
+    }//if
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED){
+        return false;
+    }//if
+
+    const image_header *H = (const image_header*)map;
+    uint64_t size = st.st_size;
+    bool ok = ! memcmp(H->magic, IMAGE_MAGIC, sizeof(H->magic))
+        && H->version == IMAGE_VERSION
+        && H->sizes[0] == sizeof(image_header)
+        && H->sizes[1] == sizeof(field_extractor)
+        && H->sizes[2] == sizeof(register_layout)
+        && H->source_size == source.st_size
+        && table_fits(H->names_offset, H->names_size, size, 1)
+        && table_fits(H->fields_offset, H->number_of_fields, size,
+                      sizeof(field_extractor))
+        && table_fits(H->registers_offset, H->number_of_registers, size,
+                      sizeof(register_layout))
+        && table_fits(H->buckets_offset, H->number_of_buckets, size,
+                      sizeof(uint32_t))
+        && table_fits(H->values_offset, H->number_of_values, size,
+                      sizeof(uint32_t))
+        && table_fits(H->masks_offset, H->number_of_masks, size,
+                      sizeof(uint64_t))
+        && H->number_of_registers < UINT32_MAX
+        && H->number_of_buckets > H->number_of_registers
+        && H->number_of_buckets <= UINT32_MAX
+        && ! (H->number_of_buckets & (H->number_of_buckets - 1));
+    /* the spec file may have been touched without being changed */
+    if(ok && (H->source_mtime[0] != source.st_mtim.tv_sec
+              || H->source_mtime[1] != source.st_mtim.tv_nsec)){
+        ok = H->source_hash == content_hash(filename);
+    }//if
+    /* a damaged cache whose tables still refer into each other would
+     * describe the wrong registers */
+    ok = ok && H->image_hash == hash_bytes((const char*)map + sizeof(*H),
+                                           (const char*)map + size)
+        && image_is_consistent(H, (const char*)map);
+    if(! ok){
+        munmap(map, st.st_size);
+        return false;
+    }//if
+
+    image = map;
+    image_size = st.st_size;
+    __names = (const char*)map + H->names_offset;
+    __fields = (const field_extractor*)((const char*)map + H->fields_offset);
+    __registers = (const register_layout*)((const char*)map
+                                           + H->registers_offset);
+    __buckets = (const uint32_t*)((const char*)map + H->buckets_offset);
+    __values = (const uint32_t*)((const char*)map + H->values_offset);
+    __masks = (const uint64_t*)((const char*)map + H->masks_offset);
+    __number_of_registers = H->number_of_registers;
+    __number_of_buckets = H->number_of_buckets;
+    __max_number_of_fields = H->max_number_of_fields;
+    return true;
+}//load_image
+
+/*****************************************************************/
+
+void spec_file::save_image(){
+    const char *filename = source_name.c_str();
+    image_header H;
+    memset(&H, 0, sizeof(H));
+    memcpy(H.magic, IMAGE_MAGIC, sizeof(H.magic));
+    H.version = IMAGE_VERSION;
+    H.sizes[0] = sizeof(image_header);
+    H.sizes[1] = sizeof(field_extractor);
+    H.sizes[2] = sizeof(register_layout);
+    H.source_size = source_size;
+    H.source_mtime[0] = source_mtime[0];
+    H.source_mtime[1] = source_mtime[1];
+
+    /* the hash must describe the contents that were read */
+    struct stat st;
+    if(stat(filename, &st) || st.st_size != source_size
+       || st.st_mtim.tv_sec != source_mtime[0]
+       || st.st_mtim.tv_nsec != source_mtime[1]){
+        throw(reg_info_exception({"'", filename,
+                        "' has changed since it was read"}));
+    }//if
+    H.source_hash = content_hash(filename);
+
+    for(register_layout &R : registers){
+        if(! R.parsed){
+            load_body(R);
+        }//if
+    }//for
+
+    H.names_offset = align8(sizeof(H));
+    H.names_size = names.size();
+    H.fields_offset = align8(H.names_offset + H.names_size);
+    H.number_of_fields = fields.size();
+    H.registers_offset = align8(H.fields_offset
+                                + fields.size() * sizeof(field_extractor));
+    H.number_of_registers = registers.size();
+    H.buckets_offset = align8(H.registers_offset
+                              + registers.size() * sizeof(register_layout));
+    H.number_of_buckets = buckets.size();
+    H.values_offset = align8(H.buckets_offset
+                             + buckets.size() * sizeof(uint32_t));
+    H.number_of_values = values.size();
+    H.masks_offset = align8(H.values_offset
+                            + values.size() * sizeof(uint32_t));
+    H.number_of_masks = masks.size();
+    H.max_number_of_fields = __max_number_of_fields;
+
+    string image(H.masks_offset + masks.size() * sizeof(uint64_t), 0);
+    memcpy(&image[H.names_offset], names.data(), names.size());
+    memcpy(&image[H.fields_offset], fields.data(),
+           fields.size() * sizeof(field_extractor));
+    memcpy(&image[H.registers_offset], registers.data(),
+           registers.size() * sizeof(register_layout));
+    memcpy(&image[H.buckets_offset], buckets.data(),
+           buckets.size() * sizeof(uint32_t));
+    memcpy(&image[H.values_offset], values.data(),
+           values.size() * sizeof(uint32_t));
+    memcpy(&image[H.masks_offset], masks.data(),
+           masks.size() * sizeof(uint64_t));
+    H.image_hash = hash_bytes(&image[sizeof(H)], &image[0] + image.size());
+    memcpy(&image[0], &H, sizeof(H));
+
+    /* written under a temporary name and renamed, so that other processes
+     * never see a partial file */
+    string image_name = string(filename) + IMAGE_SUFFIX;
+    string tmp_name = image_name + "." + to_string(getpid());
+    FILE *f = fopen(tmp_name.c_str(), "wb");
+    if(! f){
+        throw(reg_info_exception({"cannot write file '", tmp_name.c_str(),
+                        "'"}));
+    }//if
+    bool ok = fwrite(image.data(), 1, image.size(), f) == image.size();
+    ok = (fclose(f) == 0) && ok;
+    if(! ok || rename(tmp_name.c_str(), image_name.c_str())){
+        unlink(tmp_name.c_str());
+        throw(reg_info_exception({"cannot write file '", image_name.c_str(),
+                        "'"}));
+    }//if
+}//save_image
+
+/*****************************************************************/
+
+void spec_file::keep_snapshot(){
+    struct stat st;
+    has_snapshot = ! image && source_fd >= 0 && ! fstat(source_fd, &st)
+        && st.st_size == source_size
+        && st.st_mtim.tv_sec == source_mtime[0]
+        && st.st_mtim.tv_nsec == source_mtime[1]
+        && read_text(source_fd, st, snapshot);
+    if(! has_snapshot){
+        snapshot.clear();
+    }//if
+}//keep_snapshot
+
+/*****************************************************************/
+
+bool spec_file::reload(uint32_t &removed, uint32_t &parsed){
+    removed = 0;
+    parsed = 0;
+    if(! has_snapshot || redefinitions){
+        return false;
+    }//if
+    int fd = open(source_name.c_str(), O_RDONLY);
+    struct stat st;
+    string text;
+    if(fd < 0 || fstat(fd, &st) || ! S_ISREG(st.st_mode)
+       || ! read_text(fd, st, text)){
+        if(fd >= 0){
+            close(fd);
+        }//if
+        throw(reg_info_exception({"cannot read file '", source_name.c_str(),
+                        "'"}));
+    }//if
+
+    /* lines lo..hi_old-1 of the snapshot have been replaced by lines
+     * lo..hi_new-1 of text; the rest is the same */
+    const char *a = snapshot.data();
+    const char *b = text.data();
+    size_t n = min(snapshot.length(), text.length());
+    size_t lo = common_prefix(a, b, n);
+    size_t suffix = common_suffix(a + snapshot.length(), b + text.length(),
+                                  n - lo);
+    size_t hi_old = snapshot.length() - suffix;
+    size_t hi_new = text.length() - suffix;
+    while(lo && a[lo - 1] != '\n'){
+        lo--;
+    }//while
+    if(hi_old > lo || hi_new > lo){
+        if((hi_old > lo && a[hi_old - 1] != '\n')
+           || (hi_new > lo && b[hi_new - 1] != '\n')){
+            const char *eol = (const char*)memchr(a + hi_old, '\n',
+                                                  snapshot.length() - hi_old);
+            size_t k = eol ? eol + 1 - (a + hi_old)
+                : snapshot.length() - hi_old;
+            hi_old += k;
+            hi_new += k;
+        }//if
+
+        /* definitions overlapping those lines are parsed again with them */
+        vector<bool> affected(registers.size(), false);
+        size_t begin = lo;
+        size_t end = hi_old;
+        for(uint32_t i = 0; i < registers.size(); i++){
+            const register_layout &R = registers[i];
+            size_t header = R.body - 1; // '\n' ending the header line
+            while(header && a[header - 1] != '\n'){
+                header--;
+            }//while
+            size_t closing = R.body + R.body_length;
+            const char *eol = (const char*)memchr(a + closing, '\n',
+                                                  snapshot.length() - closing);
+            closing = eol ? eol + 1 - a : snapshot.length();
+            if(header < hi_old && closing > lo){
+                affected[i] = true;
+                removed++;
+                begin = min(begin, header);
+                end = max(end, closing);
+            }//if
+        }//for
+        int64_t delta = (int64_t)text.length() - (int64_t)snapshot.length();
+
+        vector<register_layout> R;
+        try{
+            parse(b + begin, b + end + delta, begin, count(a, a + begin, '\n'),
+                  R);
+        }//try
+        catch(reg_info_exception&){
+            close(fd);
+            return false; // a full reload reports the right error
+        }//catch
+        parsed = R.size();
+
+        int64_t line_delta = count(b + begin, b + end + delta, '\n')
+            - count(a + begin, a + end, '\n');
+        for(uint32_t i = 0; i < registers.size(); i++){
+            if(affected[i]){
+                continue;
+            }//if
+            R.push_back(registers[i]);
+            if(registers[i].body >= end){
+                R.back().body += delta;
+                R.back().first_line += line_delta;
+            }//if
+        }//for
+        vector<uint32_t> B;
+        if(build_index(R, names.data(), B)){
+            close(fd);
+            return false; // redefinitions are resolved in file order
+        }//if
+        registers.swap(R);
+        buckets.swap(B);
+    }//if
+
+    close(source_fd);
+    source_fd = fd;
+    source_size = st.st_size;
+    source_mtime[0] = st.st_mtim.tv_sec;
+    source_mtime[1] = st.st_mtim.tv_nsec;
+    snapshot.swap(text);
+
+    __names = names.data();
+    __registers = registers.data();
+    __buckets = buckets.data();
+    __masks = masks.data();
+    __number_of_registers = registers.size();
+    __number_of_buckets = buckets.size();
+    return true;
+}//reload
+
+/*****************************************************************/
+
+void spec_file::compile(register_layout &R){
+    R.name_width = strlen(name(R.name));
+    R.bin_width = 3;
+    R.multi_index = false;
+
+    field_extractor *F = fields.data() + R.first_field;
+    for(field_extractor *end = F + R.number_of_fields; F < end; F++){
+        uint16_t width = F->hi - F->lo + 1;
+        F->hi = R.width - 1 - F->lo;
+        F->lo = F->hi - width + 1;
+        F->limb = F->lo / limbs::LIMB_BITS;
+        F->shift = F->lo % limbs::LIMB_BITS;
+        F->mask = width >= limbs::LIMB_BITS
+            ? ~UINT64_C(0) : (UINT64_C(1) << width) - 1;
+        if(width > 1){
+            R.multi_index = true;
+        }//if
+        if(F->name_length > R.name_width){
+            R.name_width = F->name_length;
+        }//if
+        if(width > R.bin_width){
+            R.bin_width = width;
+        }//if
+    }//for
+
+    R.hex_width = max(3, (R.bin_width + 3) / 4);
+    R.index_width = R.width ? to_string(R.width - 1).length() : 1;
+}//compile
+
+/*****************************************************************/
+
+uint32_t spec_file::add_name(const char *a, size_t length){
+    uint32_t response = names.size();
+    names.insert(names.end(), a, a + length);
+    names.push_back(0);
+    __names = names.data();
+    return response;
+}//add_name
+
+/*****************************************************************/
+
+const register_layout *spec_file::layout(const string &regname){
+    if(! __number_of_buckets){
+        return NULL;
+    }//if
+    uint32_t b = __buckets[probe(__buckets, __number_of_buckets, __registers,
+                                 __names, regname.c_str(),
+                                 regname.length())];
+    if(! b){
+        return NULL;
+    }//if
+    return layout_at(b - 1);
+}//layout
+
+/*****************************************************************/
+
+const register_layout *spec_file::layout_at(uint32_t i){
+    if(! __registers[i].parsed){ // only if read from spec file
+        load_body(registers[i]);
+    }//if
+    return &__registers[i];
+}//layout_at
+
+/* aczutro ************************************************************* end */
@@ -0,0 +1,526 @@
+/* aczutro -*- c-basic-offset:4 -*-
+ *
+ * hexcalc - a handy hex calculator and register contents visualiser
+ *           for assembly programmers
+ *
+ * Copyright 2014 - 2017 Alexander Czutro
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public Licence as published by
+ * the Free Software Foundation, either version 3 of the Licence, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public Licence for more details.
+ *
+ * You should have received a copy of the GNU General Public Licence
+ * along with this program.  If not, see <http://www.gnu.org/licences/>.
+ *
+ ******************************************************************* aczutro */
+
+#include <cctype>
+#include <cstring>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#include <limbs.hh>
+#include <text-codec.hh>
+
+
+/*** help functions and constants **************************************/
+
+static const char dec2hex[] = "0123456789abcdef";
+
+/* maps '0'..'9', 'a'..'f' and 'A'..'F' to 0..15 */
+inline static uint8_t hex2dec(char a){
+    return (a & 0xf) + 9 * (a >> 6);
+}//hex2dec
+
+/* Decimal numbers are converted in chunks of DEC_CHUNK digits, i.e. the
+ * largest power of 10 that fits into a limb, so that a limb is divided or
+ * multiplied once per 19 digits instead of once per digit. */
+#define DEC_CHUNK 19
+
+static const uint64_t __pow10[] = {
+    UINT64_C(1),                   // 10 ^ 0
+    UINT64_C(10),                  // 10 ^ 1
+    UINT64_C(100),                 // 10 ^ 2
+    UINT64_C(1000),                // 10 ^ 3
+    UINT64_C(10000),               // 10 ^ 4
+    UINT64_C(100000),              // 10 ^ 5
+    UINT64_C(1000000),             // 10 ^ 6
+    UINT64_C(10000000),            // 10 ^ 7
+    UINT64_C(100000000),           // 10 ^ 8
+    UINT64_C(1000000000),          // 10 ^ 9
+    UINT64_C(10000000000),         // 10 ^ 10
+    UINT64_C(100000000000),        // 10 ^ 11
+    UINT64_C(1000000000000),       // 10 ^ 12
+    UINT64_C(10000000000000),      // 10 ^ 13
+    UINT64_C(100000000000000),     // 10 ^ 14
+    UINT64_C(1000000000000000),    // 10 ^ 15
+    UINT64_C(10000000000000000),   // 10 ^ 16
+    UINT64_C(100000000000000000),  // 10 ^ 17
+    UINT64_C(1000000000000000000), // 10 ^ 18
+    UINT64_C(10000000000000000000) // 10 ^ 19
+};
+
+/* "00", "01", ..., "99" */
+static const char dec_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* "00", "01", ..., "ff" */
+static const char hex_pairs[] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+/* bin_bytes.a[i] holds the 8 binary digits of i, most significant first */
+static const struct bin_table{
+    char a[256][8];
+    bin_table(){
+        for(uint16_t i = 0; i < 256; i++){
+            for(uint8_t j = 0; j < 8; j++){
+                a[i][j] = '0' + ((i >> (7 - j)) & 1);
+            }//for
+        }//for
+    }//bin_table
+} bin_bytes;
+
+/* returns byte i of the limbs, counting from the least significant one */
+inline static uint8_t byte(const uint64_t *limbs, uint16_t i){
+    return limbs[i / 8] >> (i % 8 * 8);
+}//byte
+
+/* Writes a < 10 ^ DEC_CHUNK into the characters before ch, backwards.  If
+ * pad, exactly DEC_CHUNK digits are written (with leading 0s).  Returns
+ * pointer to the first digit. */
+static char *render_chunk(uint64_t a, char *ch, bool pad){
+    char *first = ch - DEC_CHUNK;
+    while(a >= 100){
+        ch -= 2;
+        memcpy(ch, dec_pairs + 2 * (a % 100), 2);
+        a /= 100;
+    }//while
+    if(a >= 10){
+        ch -= 2;
+        memcpy(ch, dec_pairs + 2 * a, 2);
+    }else{
+        *--ch = '0' + a;
+    }//else
+    if(pad){
+        while(ch > first){
+            *--ch = '0';
+        }//while
+    }//if
+    return ch;
+}//render_chunk
+
+
+/*** parsing kernels ****************************************************/
+
+/* Every parser converts the characters a..end-1 into number_of_limbs limbs
+ * and returns false as soon as it finds an illegal character.  Characters
+ * that don't fit into the limbs are checked, too.  The vectorised parsers
+ * handle 16 (SSE) or 32 (AVX2) characters per step and leave the remainder
+ * to the scalar ones; the best one for the CPU at hand is picked when the
+ * program starts. */
+
+typedef bool (*parser)(const char *a, const char *end,
+                       uint64_t *limbs, uint8_t number_of_limbs);
+
+static bool parse_hex_scalar(const char *a, const char *end,
+                             uint64_t *limbs, uint8_t number_of_limbs){
+    for(uint8_t i = 0; i < number_of_limbs; i++){
+        uint64_t value = 0;
+        const char *begin = end - a > 16 ? end - 16 : a;
+        for(const char *ch = begin; ch < end; ch++){
+            if(! isxdigit(*ch)){
+                return false;
+            }//if
+            value = (value << 4) | hex2dec(*ch);
+        }//for
+        limbs[i] = value;
+        end = begin;
+    }//for
+    for(; a < end; a++){
+        if(! isxdigit(*a)){
+            return false;
+        }//if
+    }//for
+    return true;
+}//parse_hex_scalar
+
+/*****************************************************************/
+
+static bool parse_bin_scalar(const char *a, const char *end,
+                             uint64_t *limbs, uint8_t number_of_limbs){
+    for(uint8_t i = 0; i < number_of_limbs; i++){
+        uint64_t value = 0;
+        const char *begin = end - a > 64 ? end - 64 : a;
+        for(const char *ch = begin; ch < end; ch++){
+            if((*ch & ~1) != '0'){
+                return false;
+            }//if
+            value = (value << 1) | (*ch & 1);
+        }//for
+        limbs[i] = value;
+        end = begin;
+    }//for
+    for(; a < end; a++){
+        if((*a & ~1) != '0'){
+            return false;
+        }//if
+    }//for
+    return true;
+}//parse_bin_scalar
+
+#ifdef __x86_64__
+
+/*****************************************************************/
+
+/* converts the 16 hex digits at a into *value */
+__attribute__((target("sse4.2")))
+inline static bool hex16_sse(const char *a, uint64_t *value){
+    __m128i ch     = _mm_loadu_si128((const __m128i*)a);
+    __m128i digit  = _mm_sub_epi8(ch, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(ch, _mm_set1_epi8(0x20)),
+                                  _mm_set1_epi8('a'));
+    __m128i is_digit  = _mm_cmpeq_epi8(_mm_min_epu8(digit,
+                                                    _mm_set1_epi8(9)),
+                                       digit);
+    __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter,
+                                                    _mm_set1_epi8(5)),
+                                       letter);
+    if(_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff){
+        return false;
+    }//if
+    __m128i nibbles = _mm_or_si128(
+        _mm_and_si128(is_digit, digit),
+        _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+    /* 16 * even nibble + odd nibble, i.e. one byte per pair of digits, most
+     * significant byte first */
+    __m128i pairs = _mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x0110));
+    *value = __builtin_bswap64(
+        _mm_cvtsi128_si64(_mm_packus_epi16(pairs, pairs)));
+    return true;
+}//hex16_sse
+
+/*****************************************************************/
+
+/* converts the 16 binary digits at a into *value */
+__attribute__((target("sse4.2")))
+inline static bool bin16_sse(const char *a, uint64_t *value){
+    __m128i bit = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)a),
+                               _mm_set1_epi8('0'));
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(bit, _mm_set1_epi8(1)),
+                                        bit)) != 0xffff){
+        return false;
+    }//if
+    /* reversed, so that the last digit ends up in bit 0 */
+    bit = _mm_shuffle_epi8(bit, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                              7, 6, 5, 4, 3, 2, 1, 0));
+    *value = _mm_movemask_epi8(_mm_cmpeq_epi8(bit, _mm_set1_epi8(1)));
+    return true;
+}//bin16_sse
+
+/*****************************************************************/
+
+/* converts the 32 hex digits at a into limbs[1] (first 16) and limbs[0] */
+__attribute__((target("avx2")))
+inline static bool hex32_avx2(const char *a, uint64_t *limbs){
+    __m256i ch     = _mm256_loadu_si256((const __m256i*)a);
+    __m256i digit  = _mm256_sub_epi8(ch, _mm256_set1_epi8('0'));
+    __m256i letter = _mm256_sub_epi8(_mm256_or_si256(ch,
+                                                     _mm256_set1_epi8(0x20)),
+                                     _mm256_set1_epi8('a'));
+    __m256i is_digit  = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i is_letter = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+    if(~_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter))){
+        return false;
+    }//if
+    __m256i nibbles = _mm256_or_si256(
+        _mm256_and_si256(is_digit, digit),
+        _mm256_and_si256(is_letter,
+                         _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+    __m256i pairs = _mm256_maddubs_epi16(nibbles, _mm256_set1_epi16(0x0110));
+    /* packing works per 128-bit lane: bytes 0..7 and 16..23 hold the
+     * result */
+    __m256i bytes = _mm256_packus_epi16(pairs, pairs);
+    limbs[1] = __builtin_bswap64(_mm256_extract_epi64(bytes, 0));
+    limbs[0] = __builtin_bswap64(_mm256_extract_epi64(bytes, 2));
+    return true;
+}//hex32_avx2
+
+/*****************************************************************/
+
+/* converts the 32 binary digits at a into *value */
+__attribute__((target("avx2")))
+inline static bool bin32_avx2(const char *a, uint64_t *value){
+    __m256i bit = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i*)a),
+                                  _mm256_set1_epi8('0'));
+    if(~_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                                 _mm256_min_epu8(bit, _mm256_set1_epi8(1)),
+                                 bit))){
+        return false;
+    }//if
+    /* reversed within each lane, then lanes swapped */
+    bit = _mm256_shuffle_epi8(bit, _mm256_setr_epi8(
+                                  15, 14, 13, 12, 11, 10, 9, 8,
+                                  7, 6, 5, 4, 3, 2, 1, 0,
+                                  15, 14, 13, 12, 11, 10, 9, 8,
+                                  7, 6, 5, 4, 3, 2, 1, 0));
+    bit = _mm256_permute4x64_epi64(bit, 0x4e);
+    *value = (uint32_t)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(bit, _mm256_set1_epi8(1)));
+    return true;
+}//bin32_avx2
+
+/*****************************************************************/
+
+__attribute__((target("sse4.2")))
+static bool parse_hex_sse(const char *a, const char *end,
+                          uint64_t *limbs, uint8_t number_of_limbs){
+    uint8_t i = 0;
+    for(; i < number_of_limbs && end - a >= 16; i++){
+        end -= 16;
+        if(! hex16_sse(end, limbs + i)){
+            return false;
+        }//if
+    }//for
+    if(i < number_of_limbs){
+        return parse_hex_scalar(a, end, limbs + i, number_of_limbs - i);
+    }//if
+    for(uint64_t ignored; end - a >= 16; end -= 16){
+        if(! hex16_sse(end - 16, &ignored)){
+            return false;
+        }//if
+    }//for
+    return parse_hex_scalar(a, end, NULL, 0);
+}//parse_hex_sse
+
+/*****************************************************************/
+
+__attribute__((target("sse4.2")))
+static bool parse_bin_sse(const char *a, const char *end,
+                          uint64_t *limbs, uint8_t number_of_limbs){
+    uint8_t i = 0;
+    for(; i < number_of_limbs && end - a >= 64; i++){
+        uint64_t value = 0;
+        for(uint8_t shift = 0; shift < 64; shift += 16){
+            uint64_t group;
+            end -= 16;
+            if(! bin16_sse(end, &group)){
+                return false;
+            }//if
+            value |= group << shift;
+        }//for
+        limbs[i] = value;
+    }//for
+    if(i < number_of_limbs){
+        return parse_bin_scalar(a, end, limbs + i, number_of_limbs - i);
+    }//if
+    for(uint64_t ignored; end - a >= 16; end -= 16){
+        if(! bin16_sse(end - 16, &ignored)){
+            return false;
+        }//if
+    }//for
+    return parse_bin_scalar(a, end, NULL, 0);
+}//parse_bin_sse
+
+/*****************************************************************/
+
+__attribute__((target("avx2")))
+static bool parse_hex_avx2(const char *a, const char *end,
+                           uint64_t *limbs, uint8_t number_of_limbs){
+    uint8_t i = 0;
+    for(; i + 1 < number_of_limbs && end - a >= 32; i += 2){
+        end -= 32;
+        if(! hex32_avx2(end, limbs + i)){
+            return false;
+        }//if
+    }//for
+    return parse_hex_sse(a, end, limbs + i, number_of_limbs - i);
+}//parse_hex_avx2
+
+/*****************************************************************/
+
+__attribute__((target("avx2")))
+static bool parse_bin_avx2(const char *a, const char *end,
+                           uint64_t *limbs, uint8_t number_of_limbs){
+    uint8_t i = 0;
+    for(; i < number_of_limbs && end - a >= 64; i++){
+        uint64_t lo, hi;
+        if(! (bin32_avx2(end - 32, &lo) && bin32_avx2(end - 64, &hi))){
+            return false;
+        }//if
+        limbs[i] = (hi << 32) | lo;
+        end -= 64;
+    }//for
+    return parse_bin_sse(a, end, limbs + i, number_of_limbs - i);
+}//parse_bin_avx2
+
+#endif
+
+/*****************************************************************/
+
+static parser select_hex_parser(){
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        return parse_hex_avx2;
+    }//if
+    if(__builtin_cpu_supports("sse4.2")){
+        return parse_hex_sse;
+    }//if
+#endif
+    return parse_hex_scalar;
+}//select_hex_parser
+
+/*****************************************************************/
+
+static parser select_bin_parser(){
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        return parse_bin_avx2;
+    }//if
+    if(__builtin_cpu_supports("sse4.2")){
+        return parse_bin_sse;
+    }//if
+#endif
+    return parse_bin_scalar;
+}//select_bin_parser
+
+static const parser hex_parser = select_hex_parser();
+static const parser bin_parser = select_bin_parser();
+
+
+/*** namespace text_codec functions ************************************/
+
+bool text_codec::parse_hex(const char *a, size_t n,
+                           uint64_t *limbs, uint8_t number_of_limbs){
+    return hex_parser(a, a + n, limbs, number_of_limbs);
+}//parse_hex
+
+/*****************************************************************/
+
+bool text_codec::parse_bin(const char *a, size_t n,
+                           uint64_t *limbs, uint8_t number_of_limbs){
+    return bin_parser(a, a + n, limbs, number_of_limbs);
+}//parse_bin
+
+/*****************************************************************/
+
+bool text_codec::parse_dec(const char *a, size_t n,
+                           uint64_t *limbs, uint8_t number_of_limbs){
+    for(uint8_t i = 0; i < number_of_limbs; i++){
+        limbs[i] = 0;
+    }//for
+    const char *end = a + n;
+    while(a < end){
+        uint8_t  digits = end - a < DEC_CHUNK ? end - a : DEC_CHUNK;
+        uint64_t chunk  = 0;
+        for(const char *stop = a + digits; a < stop; a++){
+            chunk = chunk * 10 + (*a - '0');
+        }//for
+        if(limbs::mul_add(limbs, number_of_limbs, __pow10[digits], chunk)){
+            return false;
+        }//if
+    }//while
+    return true;
+}//parse_dec
+
+/*****************************************************************/
+
+void text_codec::render_hex(const uint64_t *limbs, uint8_t digits, char *a){
+    if(digits % 2){
+        digits--;
+        *a++ = dec2hex[(limbs[digits / 16] >> (digits % 16 * 4)) & 0xf];
+    }//if
+    while(digits){
+        digits -= 2;
+        memcpy(a, hex_pairs + 2 * byte(limbs, digits / 2), 2);
+        a += 2;
+    }//while
+}//render_hex
+
+/*****************************************************************/
+
+void text_codec::render_bin(const uint64_t *limbs, uint16_t bits, char *a){
+    if(bits % 8){
+        memcpy(a, bin_bytes.a[byte(limbs, bits / 8)] + 8 - bits % 8, bits % 8);
+        a += bits % 8;
+        bits -= bits % 8;
+    }//if
+    while(bits){
+        bits -= 8;
+        memcpy(a, bin_bytes.a[byte(limbs, bits / 8)], 8);
+        a += 8;
+    }//while
+}//render_bin
+
+/*****************************************************************/
+
+size_t text_codec::render_bin_groups(const uint64_t *limbs, uint16_t bits,
+                                     char separator, char *a){
+    if(! bits){
+        return 0;
+    }//if
+    size_t response = bits + (bits - 1) / 4;
+    uint16_t group = bits % 4 ? bits % 4 : 4;
+    while(true){
+        bits -= group;
+        uint8_t nibble = (limbs[bits / 64] >> (bits % 64)) & 0xf;
+        memcpy(a, bin_bytes.a[nibble] + 8 - group, group);
+        a += group;
+        if(! bits){
+            return response;
+        }//if
+        *a++ = separator;
+        group = 4;
+    }//while
+}//render_bin_groups
+
+/*****************************************************************/
+
+size_t text_codec::render_dec(uint64_t *limbs, uint8_t number_of_limbs,
+                              char *a){
+    /* chunks are produced least significant first, so they are written
+     * backwards from the end of a and moved to the front afterwards */
+    char *end = a + 20 * number_of_limbs;
+    char *ch = end;
+    uint8_t n = number_of_limbs;
+    while(n && ! limbs[n - 1]){
+        n--;
+    }//while
+    while(n > 1 || (n == 1 && limbs[0] >= __pow10[DEC_CHUNK])){
+        ch = render_chunk(limbs::div_mod(limbs, n, __pow10[DEC_CHUNK]),
+                          ch, true);
+        if(! limbs[n - 1]){
+            n--;
+        }//if
+    }//while
+    ch = render_chunk(n ? limbs[0] : 0, ch, false);
+    limbs[0] = 0;
+    size_t response = end - ch;
+    memmove(a, ch, response);
+    a[response] = 0;
+    return response;
+}//render_dec
+
+/* aczutro ************************************************************* end */
@@ -0,0 +1,631 @@
+#!/bin/sh
+# aczutro
+#
+# hexcalc - a handy hex calculator and register contents visualiser
+#           for assembly programmers
+#
+# Copyright 2014 - 2017 Alexander Czutro
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public Licence as published by
+# the Free Software Foundation, either version 3 of the Licence, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public Licence for more details.
+#
+# You should have received a copy of the GNU General Public Licence
+# along with this program.  If not, see <http://www.gnu.org/licences/>.
+#
+################################################################### aczutro ###
+
+# Regression tests, run by "make check" in bin/: run-tests.sh HEXCALC
+# Every test runs hexcalc once, interactively or in batch mode, and checks its
+# exit status and output.
+
+HEXCALC=${1:-hexcalc}
+DIR=$(dirname "$0")
+SPECS=$DIR/specs
+TMP=${TMPDIR:-/tmp}/hexcalc-tests.$$
+ESC=$(printf '\033')
+failures=0
+
+# run COMMAND...: runs COMMAND, keeping its exit status in status, and its
+# output (both streams, without colours) in $TMP
+run(){
+    "$@" > "$TMP.raw" 2>&1
+    status=$?
+    sed "s/$ESC\[[0-9;]*m//g" "$TMP.raw" > "$TMP"
+}
+
+# session COMMAND...: runs hexcalc interactively on the given commands, one
+# per argument, followed by q
+session(){
+    printf '%s\n' "$@" q > "$TMP.in"
+    run "$HEXCALC" < "$TMP.in"
+}
+
+# fail NAME: reports a failed test with the output of its run
+fail(){
+    echo "FAIL: $1 (exit status $status)"
+    cat "$TMP"
+    failures=$((failures + 1))
+}
+
+# expect NAME STATUS PATTERN: checks the exit status of the last run, and
+# that a line of its output matches PATTERN
+expect(){
+    if [ "$status" -ne "$2" ] || ! grep -q -- "$3" "$TMP"; then
+        fail "$1"
+    else
+        echo "ok:   $1"
+    fi
+}
+
+# expect_not NAME PATTERN: checks that no line of the output of the last run
+# matches PATTERN
+expect_not(){
+    if grep -q -- "$2" "$TMP"; then
+        fail "$1"
+    else
+        echo "ok:   $1"
+    fi
+}
+
+# expect_same NAME FILE1 FILE2: checks that two files have the same contents
+expect_same(){
+    if ! cmp -s "$2" "$3"; then
+        echo "FAIL: $1 ($2 and $3 differ)"
+        failures=$((failures + 1))
+    else
+        echo "ok:   $1"
+    fi
+}
+
+# check NAME COMMAND...: checks that COMMAND succeeds
+check(){
+    name=$1
+    shift
+    if ! "$@"; then
+        fail "$name"
+    else
+        echo "ok:   $name"
+    fi
+}
+
+# spec_error NAME PATTERN TEXT: checks that decoding with a spec file
+# containing TEXT (a printf format) fails with an error matching PATTERN
+spec_error(){
+    printf "$3" > "$TMP.spec"
+    run "$HEXCALC" --decode a --spec "$TMP.spec" "$TMP.trace"
+    expect "$1" 2 "spec:$2"
+}
+
+### spec parser ###############################################################
+
+# widths of fields that add up to more than 16 bits are rejected while the
+# register definitions are located (user-014), before any reserved-bit mask
+# is built
+run "$HEXCALC" --decode wrapped --spec "$SPECS/wrapped-width" /dev/null
+expect "batch: wrapped register width" 2 "exceeds 65535 bits"
+
+session "R $SPECS/wrapped-width"
+expect "interactive: wrapped register width" 0 "exceeds 65535 bits"
+
+echo 1 > "$TMP.trace"
+spec_error "spec: width not divisible by 4" \
+           "4: total width of register a (7) is not divisible by 4" \
+           '0 a\n4 x\n3 y\n0\n'
+spec_error "spec: incomplete last register" \
+           " unexpected end of file; last register definition is incomplete" \
+           '0 a\n4 x\n'
+spec_error "spec: missing declaration" \
+           "1: expected new register declaration starting with 0" '1 a\n'
+spec_error "spec: missing register name" "1:  expected register name" '0\n'
+spec_error "spec: extra token" "2:  unexpected token 'y'" '0 a\n4 x y\n0\n'
+spec_error "spec: field width not a number" \
+           "3: expected a positive number, but read 'foo'" '0 a\n4 x\nfoo\n0\n'
+
+printf '\n0 a\t\r\n\t4   x  \r\n 0' > "$TMP.spec"
+run "$HEXCALC" --decode a --spec "$TMP.spec" "$TMP.trace"
+expect "spec: blanks, carriage returns and no last newline" 0 "^1 x=1$"
+
+# lines are not limited in length
+LONG=$(awk 'BEGIN { for(i = 0; i < 5000; i++) printf "n" }')
+printf '0 %s\n4 x\n0\n' "$LONG" > "$TMP.spec"
+run "$HEXCALC" --decode "$LONG" --spec "$TMP.spec" "$TMP.trace"
+expect "spec: 5000-character register name" 0 "^1 x=1$"
+
+# register bodies are parsed on first use, so that an error in one only
+# affects that register (user-015)
+printf '0 a\n4 x y\n0\n0 b\n4 z\n0\n' > "$TMP.spec"
+
+run "$HEXCALC" --decode a --spec "$TMP.spec" "$TMP.trace"
+expect "spec: error in the body of the register" 2 "spec:2:  unexpected token 'y'"
+
+run "$HEXCALC" --decode b --spec "$TMP.spec" "$TMP.trace"
+expect "spec: error in the body of another register" 0 "^1 z=1$"
+
+session "R $TMP.spec" "w 1" 1 "s b" "s a" "s b"
+expect "spec: s on a body with an error" 0 "spec:2:  unexpected token 'y'"
+expect "spec: s after a body with an error" 0 "^z \[3\.\.0\] = 0001"
+
+### field labels ##############################################################
+
+# bit indices of 256-bit registers have three digits
+session "R $SPECS/cpu" "w 64" "f$(printf '%062d' 0)1" "s wide"
+expect "s: three-digit index" 0 "^   top \[255\.\.252\] = 1111 "
+expect "s: padded index" 0 "^bottom \[  3\.\.  0\] = 0001 "
+
+### reserved bits #############################################################
+
+# values no register is as wide as
+run "$HEXCALC" --check-reserved --spec "$SPECS/r32" "$SPECS/no-width.txt"
+expect "check: no register of the value's width" 1 "no register of width 8"
+
+session "R $SPECS/cpu" "w 8" 0 V 0c1ff9f8 V
+expect "V: no reserved bits set" 0 "no reserved bits set in any of the 4 registers of width 32"
+expect "V: reserved bits of one register" 0 "^    cpuconfig \[20\.\.11\] \[8\.\.3\]$"
+expect_not "V: only registers with reserved bits set" "^    cause "
+
+session "R $SPECS/cpu" "w 64" "i 100" "i 255" V
+expect "V: reserved bits at 256 bits" 0 "^    wide \[100\]$"
+
+session "R $SPECS/cpu" "w 2" V
+expect "V: no register of the accumulator's width" 0 "no register definitions of width 8"
+
+printf '%s\n' deadbeef 0c1ff9f8 zz 00000000 > "$TMP.trace"
+
+run "$HEXCALC" --check-reserved --spec "$SPECS/cpu" "$TMP.trace"
+expect "check: all registers of a width" 1 "trace:1: reserved bits are set: cause \[31\.\.30\] \[28\] \[25\] \[23\] \[21\] \[10\.\.9\] \[2\.\.0\], cpuconfig "
+expect "check: one register of a width" 1 "trace:2: reserved bits are set: cpuconfig \[20\.\.11\] \[8\.\.3\]$"
+expect "check: illegal characters" 1 "trace:3: hexadecimal string contains illegal characters"
+expect_not "check: no reserved bits set" "trace:4"
+
+run "$HEXCALC" --check-reserved --decode cause --spec "$SPECS/cpu" "$TMP.trace"
+expect "check: one register" 1 "trace:1: reserved bits are set: cause \[31\.\.30\] \[28\] \[25\] \[23\] \[21\] \[10\.\.9\] \[2\.\.0\]$"
+expect_not "check: one register, no reserved bits set" "trace:2"
+
+printf '%s\n' 00000000 0c1ff9f8 > "$TMP.trace"
+run "$HEXCALC" --check-reserved --decode cause --spec "$SPECS/cpu" "$TMP.trace"
+expect_same "check: clean trace" "$TMP" /dev/null
+check "check: clean trace, exit status" [ "$status" -eq 0 ]
+
+### searching and completing names ############################################
+
+session "R $SPECS/cpu" deadbeef "s cause"
+expect "s: exact name" 0 "exception_code \[ 8\.\. 3\] = 011101 .*illegal_address"
+
+session "R $SPECS/cpu" deadbeef "s cau"
+expect "s: unique prefix" 0 "exception_code \[ 8\.\. 3\] = 011101"
+
+session "R $SPECS/cpu" "s c"
+expect "s: ambiguous prefix" 0 "possible completions:"
+expect "s: ambiguous prefix lists all" 0 "^    cpuconfig$"
+
+session "R $SPECS/cpu" "s nosuch"
+expect "s: no match" 0 "unknown register name"
+
+# the bodies of cause and counter are parsed on first use, which adds their
+# field names to the name table
+session "R $SPECS/cpu" deadbeef "s cause" "s cou" "s cp"
+expect "s: prefix after parsing a body" 0 "high \[31\.\.16\] = 1101111010101101"
+expect "s: second prefix after parsing bodies" 0 "cores \[31\.\.24\] = 11011110"
+
+session "R $SPECS/cpu" "/ code"
+expect "/: part of a name" 0 "^    cause\.exception_code$"
+
+session "R $SPECS/cpu" "/ c*g"
+expect "/: pattern" 0 "^    cpuconfig$"
+
+session "R $SPECS/cpu" "/ f*3"
+expect "/: pattern on field names" 0 "^    cause\.field3$"
+expect_not "/: pattern matches whole names" "field2"
+
+session "R $SPECS/cpu" "/ zzz"
+expect "/: no match" 0 "no matching registers or fields"
+
+### accumulators up to 256 bits ###############################################
+
+session "w 64" "i 255" "i 200 100" H
+expect "invert at 256 bits" 0 "^-> 80000000000001fffffffffffffffffffffffff0000000000000000000000000  wd(64)"
+
+session "w 64" "i 255" "i 200 100" "L 131 124" "= ab" H
+expect "replace across limbs" 0 "^-> 80000000000001fffffffffffffffffabffffff0000000000000000000000000  wd(64)"
+
+session "w 64" "i 255 0" "w 16" H
+expect "narrowing truncates" 0 "^-> ffffffffffffffff  wd(16)"
+
+session "w 16" ffff0000ffff0000 "w 8" "w 16" H
+expect "widening fills with zeros" 0 "^-> 00000000ffff0000  wd(16)"
+
+# ranges that end at, start at and cover limb boundaries
+session "w 64" "i 64 63" "i 191 128" "i 0" H
+expect "invert at limb boundaries" 0 "^-> 0\{16\}f\{16\}0\{15\}18000000000000001  wd(64)"
+
+# values wider than the highlighted bits are truncated
+session "w 32" "L 70 60" "= 1ff" "L 3 0" "= 1f" H "= 'b101" "= 'd9" H
+expect "replace and truncate at 128 bits" 0 "^   0\{14\}1ff0\{14\}f  wd(32)  idx  hl(3\.\.0)$"
+expect "replace with a decimal" 0 "^-> 0\{14\}1ff0\{14\}9  wd(32)  idx  hl(3\.\.0)$"
+
+session "w 4" "= 1"
+expect "replace without highlighted bits" 0 "no permanently highlighted bits"
+
+### decimal conversion ########################################################
+
+session "w 16" "'d18446744073709551615" H
+expect "decimal input at 64 bits" 0 "^-> ffffffffffffffff  wd(16)"
+
+session "w 32" "'d340282366920938463463374607431768211455" H
+expect "decimal input at 128 bits" 0 "^-> ffffffffffffffffffffffffffffffff  wd(32)"
+
+session "w 64" "'d115792089237316195423570985008687907853269984665640564039457584007913129639935" H
+expect "decimal input at 256 bits" 0 "^-> ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff  wd(64)"
+
+session "w 32" 0123456789abcdeffedcba9876543210
+expect "decimal output at 128 bits" 0 "decimal: 1512366075204170947332355369683137040$"
+
+session "w 64" 0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef
+expect "decimal output at 256 bits" 0 "decimal: 514631507721405306298073637848375664226723355710112857507800679889911926255$"
+
+session "w 32" "'d340282366920938463463374607431768211456"
+expect "decimal too large" 0 "value too large for current accumulator width"
+
+session "'d12x"
+expect "decimal with illegal characters" 0 "decimal string contains illegal characters"
+
+### batch decoding ############################################################
+
+printf '%s\n' deadbeef 0 "" xyz 123456789 "  1d" > "$TMP.trace"
+
+run "$HEXCALC" --decode cause --spec "$SPECS/cpu" "$TMP.trace"
+expect "decode: fields" 1 "^deadbeef ce=3 field3=d field2=2 field1=7 exception_code=1d"
+expect "decode: padded value" 1 "^0000001d ce=0 field3=0 field2=0 field1=0 exception_code=3$"
+expect "decode: illegal characters" 1 "trace:4: hexadecimal string contains illegal characters"
+expect "decode: value too wide" 1 "trace:5: value too large for register width"
+
+run "$HEXCALC" --decode cause --spec "$SPECS/cpu" < "$TMP.trace"
+expect "decode: standard input" 1 "^<stdin>:4: hexadecimal"
+
+run "$HEXCALC" --decode counter --spec "$SPECS/cpu" "$TMP.trace.none"
+expect "decode: missing trace" 2 "cannot open file"
+
+run "$HEXCALC" --decode nosuch --spec "$SPECS/cpu" "$TMP.trace"
+expect "decode: unknown register" 2 "nosuch: unknown register name"
+
+run "$HEXCALC" --decode cause "$TMP.trace"
+expect "decode: no spec" 2 "^usage:"
+
+# a mapped trace is decoded in place; standard input is read into a buffer
+"$HEXCALC" --decode cause --spec "$SPECS/cpu" "$TMP.trace" > "$TMP.mapped" 2> /dev/null
+"$HEXCALC" --decode cause --spec "$SPECS/cpu" < "$TMP.trace" > "$TMP.read" 2> /dev/null
+expect_same "decode: mapped file and standard input" "$TMP.mapped" "$TMP.read"
+
+printf 'deadbeef\n1d' > "$TMP.trace"
+run "$HEXCALC" --decode cause --spec "$SPECS/cpu" "$TMP.trace"
+expect "decode: last line without newline" 0 "^0000001d ce=0 "
+
+printf 'dead\r\n' > "$TMP.trace"
+run "$HEXCALC" --decode cause --spec "$SPECS/cpu" "$TMP.trace"
+expect "decode: carriage return" 0 "^0000dead ce=0 "
+
+: > "$TMP.trace"
+"$HEXCALC" --decode cause --spec "$SPECS/cpu" "$TMP.trace" > "$TMP.mapped" 2>&1
+expect_same "decode: empty file" "$TMP.mapped" /dev/null
+
+# traces larger than one chunk (4 MiB) are decoded on several threads
+awk 'BEGIN {
+    srand(1)
+    for(i = 1; i <= 600000; i++){
+        if(i % 99991 == 0) print "zz"; else printf "%08x\n", int(rand() * 4294967296)
+    }
+}' > "$TMP.trace"
+
+"$HEXCALC" --decode cause --spec "$SPECS/cpu" --jobs 1 "$TMP.trace" > "$TMP.out1" 2> "$TMP.err1"
+"$HEXCALC" --decode cause --spec "$SPECS/cpu" --jobs 4 "$TMP.trace" > "$TMP.out4" 2> "$TMP.err4"
+expect_same "decode: output of 4 jobs" "$TMP.out1" "$TMP.out4"
+expect_same "decode: errors of 4 jobs" "$TMP.err1" "$TMP.err4"
+
+"$HEXCALC" --check-reserved --spec "$SPECS/cpu" --jobs 1 "$TMP.trace" > "$TMP.out1" 2>&1
+"$HEXCALC" --check-reserved --spec "$SPECS/cpu" --jobs 4 "$TMP.trace" > "$TMP.out4" 2>&1
+expect_same "check: output of 4 jobs" "$TMP.out1" "$TMP.out4"
+
+### hex and binary input ######################################################
+
+# 0123456789abcdef, once per 64 bits
+HEX=0123456789abcdef
+BIN=0000000100100011010001010110011110001001101010111100110111101111
+
+session "w 16" "'b$BIN" H
+expect "binary input at 64 bits" 0 "^-> $HEX  wd(16)"
+
+session "w 32" "'b$BIN$BIN" H
+expect "binary input at 128 bits" 0 "^-> $HEX$HEX  wd(32)"
+
+session "w 64" "'b$BIN$BIN$BIN$BIN" H
+expect "binary input at 256 bits" 0 "^-> $HEX$HEX$HEX$HEX  wd(64)"
+
+session "w 64" "$HEX$HEX$HEX$HEX" H
+expect "hex input at 256 bits" 0 "^-> $HEX$HEX$HEX$HEX  wd(64)"
+
+session "w 64" DEADBEEF H
+expect "upper-case hex input" 0 "^-> 0\{56\}deadbeef  wd(64)"
+
+session "w 16" "1$HEX" H
+expect "hex input wider than the accumulator" 0 "^-> $HEX  wd(16)"
+
+session "w 64" "$HEX$HEX$HEX${HEX%f}g"
+expect "hex input with an illegal last digit" 0 "hexadecimal string contains illegal characters"
+
+session "w 64" "'b$BIN${BIN}2$BIN"
+expect "binary input with an illegal digit" 0 "binary string contains illegal characters"
+
+### rendering #################################################################
+
+HEX_LINE="    hex: $(echo "$HEX$HEX$HEX$HEX" | sed 's/./    &/g')"
+BIN_LINE="    bin: $(echo "$BIN$BIN$BIN$BIN" | sed 's/..../ &/g')"
+
+session "w 64" "$HEX$HEX$HEX$HEX"
+expect "hex line at 256 bits" 0 "^$HEX_LINE$"
+expect "binary line at 256 bits" 0 "^$BIN_LINE$"
+
+session "w 64" "$HEX$HEX$HEX$HEX" "L 67 60"
+expect "highlighted binary across limbs" 0 "^highlighted bin: 1111 0000$"
+expect "highlighted hex across limbs" 0 "^highlighted hex:    f    0 $"
+expect "highlighted decimal across limbs" 0 "^highlighted dec: 240$"
+
+### field extraction ##########################################################
+
+printf '%s\n' "$HEX$HEX" ffffffffffffffffffffffffffffffff > "$TMP.trace"
+
+run "$HEXCALC" --decode span --spec "$SPECS/cpu" "$TMP.trace"
+expect "decode: field across limbs" 0 "^$HEX$HEX top=0 middle=f0 low=123456789abcdef$"
+expect "decode: all bits set" 0 " top=f middle=ff low=fffffffffffffff$"
+
+session "R $SPECS/cpu" "w 32" "$HEX$HEX" "s span"
+expect "s: field across limbs" 0 "^middle \[ 67\.\. 60\] = 11110000 *f0 *240$"
+
+### register lookup ###########################################################
+
+awk 'BEGIN { for(i = 0; i < 5000; i++) printf "0 reg%d\n8 f%d\n0\n\n", i, i }' > "$TMP.spec"
+echo 5a > "$TMP.trace"
+
+run "$HEXCALC" --decode reg0 --spec "$TMP.spec" "$TMP.trace"
+expect "lookup: first of many registers" 0 "^5a f0=5a$"
+
+run "$HEXCALC" --decode reg4999 --spec "$TMP.spec" "$TMP.trace"
+expect "lookup: last of many registers" 0 "^5a f4999=5a$"
+
+run "$HEXCALC" --decode reg5000 --spec "$TMP.spec" "$TMP.trace"
+expect "lookup: unknown among many registers" 2 "reg5000: unknown register name"
+
+### spec cache ################################################################
+
+mkdir "$TMP.dir"
+cp "$SPECS/cpu" "$TMP.dir/cpu"
+CACHE=$TMP.dir/cpu.cache
+printf '%s\n' "$HEX$HEX" > "$TMP.trace"
+
+run "$HEXCALC" --compile-spec "$TMP.dir"
+expect_same "cache: compile directory" "$TMP" /dev/null
+run ls "$TMP.dir"
+expect "cache: written next to the spec file" 0 "^cpu\.cache$"
+
+run "$HEXCALC" --decode span --spec "$TMP.dir/cpu" "$TMP.trace"
+expect "cache: decode" 0 " top=0 middle=f0 low=123456789abcdef$"
+
+session "R $TMP.dir/cpu" "s cau"
+expect "cache: interactive" 0 "exception_code \[ 8\.\. 3\]"
+
+# an edit that keeps the size and time of the spec file is not noticed, which
+# shows that the cache is used
+touch -r "$TMP.dir/cpu" "$TMP.stamp"
+sed 's/middle/centre/' "$SPECS/cpu" > "$TMP.dir/cpu"
+touch -r "$TMP.stamp" "$TMP.dir/cpu"
+run "$HEXCALC" --decode span --spec "$TMP.dir/cpu" "$TMP.trace"
+expect "cache: used while the spec is unchanged" 0 " middle=f0 "
+
+sed 's/middle/mittel/' "$SPECS/cpu" > "$TMP.dir/cpu"
+run "$HEXCALC" --decode span --spec "$TMP.dir/cpu" "$TMP.trace"
+expect "cache: stale after an edit" 0 " mittel=f0 "
+
+echo "0 extra" >> "$TMP.dir/cpu"
+echo "8 byte" >> "$TMP.dir/cpu"
+echo "0" >> "$TMP.dir/cpu"
+echo 5a > "$TMP.trace.8"
+run "$HEXCALC" --decode extra --spec "$TMP.dir/cpu" "$TMP.trace.8"
+expect "cache: stale after the spec grows" 0 "^5a byte=5a$"
+
+# damaged caches: random bytes in each table, and a truncated file
+cp "$SPECS/cpu" "$TMP.dir/cpu"
+"$HEXCALC" --compile-spec "$TMP.dir/cpu"
+cp "$CACHE" "$TMP.good"
+size=$(wc -c < "$CACHE")
+offset=0
+while [ "$offset" -lt "$size" ]; do
+    cp "$TMP.good" "$CACHE"
+    printf 'damaged cache damaged cache' \
+        | dd of="$CACHE" bs=1 seek="$offset" conv=notrunc 2> /dev/null
+    run "$HEXCALC" --decode span --spec "$TMP.dir/cpu" "$TMP.trace"
+    expect "cache: damaged at byte $offset" 0 " top=0 middle=f0 low=123456789abcdef$"
+    offset=$((offset + 200))
+done
+
+head -c $((size / 2)) "$TMP.good" > "$CACHE"
+run "$HEXCALC" --decode span --spec "$TMP.dir/cpu" "$TMP.trace"
+expect "cache: truncated" 0 " top=0 middle=f0 low=123456789abcdef$"
+
+### several spec files ########################################################
+
+mkdir -p "$TMP.specs/sub"
+printf '0 a\n4 x\n0\n' > "$TMP.specs/one"
+printf '0 b\n4 y\n0\n' > "$TMP.specs/sub/two"
+printf '0 a\n4 w\n0\n' > "$TMP.specs/three"
+echo 1 > "$TMP.trace"
+
+run "$HEXCALC" --decode b --spec "$TMP.specs/one" --spec "$TMP.specs/sub" "$TMP.trace"
+expect "specs: file and directory" 0 "^1 y=1$"
+expect_not "specs: no warning without redefinitions" "warning"
+
+run "$HEXCALC" --decode a --spec "$TMP.specs/three" --spec "$TMP.specs/one" "$TMP.trace"
+expect "specs: the file named last wins" 0 "^1 x=1$"
+expect "specs: redefinition warning" 0 "warning: register 'a' of '.*/one' overrides the one of '.*/three'"
+
+# the files of a directory are taken in the order of their names
+run "$HEXCALC" --decode a --spec "$TMP.specs" "$TMP.trace"
+expect "specs: directory in order of file names" 0 "^1 w=1$"
+
+session "R $TMP.specs/one $TMP.specs/sub"
+expect "specs: R with several paths" 0 "^    b$"
+
+run "$HEXCALC" --decode a --spec "$TMP.specs/none" "$TMP.trace"
+expect "specs: missing file" 2 "cannot open file"
+
+### watching spec files #######################################################
+
+# the spec file is changed while hexcalc waits for its next command
+printf '0 a\n4 x\n0\n0 b\n4 y\n0\n0 c\n4 z\n0\n' > "$TMP.spec"
+mkfifo "$TMP.fifo"
+{
+    printf '%s\n' "R $TMP.spec" W "w 1" 1 "s b"
+    sleep 1
+    sed 's/y/why/' "$TMP.spec" > "$TMP.spec.new"
+    cat "$TMP.spec.new" > "$TMP.spec"
+    echo "s b"
+    sleep 1
+    printf '0 a\n4 x\n0 b\n' > "$TMP.spec"
+    printf '%s\n' "s b" q
+} > "$TMP.fifo" &
+run "$HEXCALC" < "$TMP.fifo"
+wait
+expect "watch: before the change" 0 "^y \[3\.\.0\] = 0001"
+expect "watch: only the changed definition is parsed" 0 "spec' changed; 1 register definitions parsed again"
+expect "watch: after the change" 0 "^why \[3\.\.0\] = 0001"
+expect "watch: a broken change is reported" 0 "spec:3: unexpected token 'b'"
+check "watch: a broken change keeps the definitions" \
+      [ "$(grep -c '^why \[3\.\.0\]' "$TMP")" -eq 2 ]
+
+### value names ###############################################################
+
+# small fields have a dense table of value names, wider ones a hashed one
+printf '0 v\n4 small\n= 0 zero\n= 15 fifteen\n12 big\n= 0x123 abc\n= 4095 top\n= 7 seven\n4\n0\n' > "$TMP.spec"
+printf '%s\n' f1230 fff00 01000 > "$TMP.trace"
+
+run "$HEXCALC" --decode v --spec "$TMP.spec" "$TMP.trace"
+expect "values: dense and hashed names" 0 "^f1230 small=f(fifteen) big=123(abc)$"
+expect "values: unnamed value in a hashed table" 0 "^fff00 small=f(fifteen) big=ff0$"
+expect "values: zero" 0 "^01000 small=0(zero) big=100$"
+
+session "R $TMP.spec" "w 5" f1230 "s v"
+expect "values: s" 0 "^  big \[15\.\. 4\] = 000100100011   123   291    abc$"
+
+printf '0 w\n64 all\n= 0xffffffffffffffff ones\n= 0x8000000000000000 msb\n= 3 three\n0\n' > "$TMP.spec"
+printf '%s\n' ffffffffffffffff 8000000000000000 4 > "$TMP.trace"
+run "$HEXCALC" --decode w --spec "$TMP.spec" "$TMP.trace"
+expect "values: 64-bit value" 0 "^ffffffffffffffff all=ffffffffffffffff(ones)$"
+expect "values: most significant bit" 0 "^8000000000000000 all=8000000000000000(msb)$"
+expect "values: unnamed 64-bit value" 0 "^0000000000000004 all=4$"
+
+spec_error "values: named twice" "4: value 1 of field x is named twice" \
+           '0 a\n4 x\n= 1 one\n= 1 uno\n0\n'
+spec_error "values: too large for the field" \
+           "3: value 16 does not fit into field x" '0 a\n4 x\n= 16 big\n0\n'
+spec_error "values: unnamed field" "3: value name without a named field" \
+           '0 a\n4\n= 1 one\n0\n'
+
+### diffs #####################################################################
+
+session "R $SPECS/cpu" "w 8" deadbeef "x cause deadbeef" "x cause dead0000"
+expect "x: equal values" 0 "the values are equal"
+expect "x: changed field" 0 "^        field1 \[13\.\.11\] = 7                     0$"
+expect "x: changed named value" 0 "^exception_code \[ 8\.\. 3\] = 1d(illegal_address)   0$"
+expect_not "x: unchanged field" "^            ce "
+
+session "R $SPECS/cpu" "w 64" "i 255" "x wide 8"
+expect "x: fields at both ends of 256 bits" 0 "^bottom \[  3\.\.  0\] = 0     8$"
+
+session "R $SPECS/cpu" "w 8" "x cause zz" "x nosuch 1" "w 2" "x cause 1"
+expect "x: illegal characters" 0 "hexadecimal string contains illegal characters"
+expect "x: unknown register" 0 "unknown register name"
+expect "x: width mismatch" 0 "requested register's width mismatches"
+
+printf '%s\n' deadbeef dead0000 dead0000 zz 0 > "$TMP.trace"
+run "$HEXCALC" --decode cause --diff --spec "$SPECS/cpu" "$TMP.trace"
+expect "diff: changed fields" 1 "^2: deadbeef -> dead0000 field2=2->0 field1=7->0 exception_code=1d(illegal_address)->0$"
+expect "diff: across a line with an error" 1 "^5: dead0000 -> 00000000 ce=3->0 field3=d->0$"
+expect_not "diff: equal values" "^3:"
+expect "diff: illegal characters" 1 "trace:4: hexadecimal string contains illegal characters"
+
+### undo history ##############################################################
+
+# entries are stored as differences, which must restore the value, the width
+# and the highlighted bits
+session 12 "w 64" "i 255" "L 7 4" u u H r H
+expect "undo: width" 0 "^-> 0\{62\}12  wd(64)  idx$"
+expect "undo: highlighted bits" 0 "^   80\{61\}12  wd(64)  idx  hl(7\.\.4)$"
+expect "redo" 0 "^-> 80\{61\}12  wd(64)  idx$"
+
+session 1 u u r r
+expect "undo: at the first entry" 0 "no more undo history"
+expect "redo: at the last entry" 0 "no more redo history"
+
+# 300 entries, all of which can be undone
+{
+    echo "U 400"
+    awk 'BEGIN { for(i = 1; i <= 300; i++) printf "%x\n", i
+                 for(i = 1; i <= 300; i++) print "u" }'
+    printf '%s\n' H u q
+} > "$TMP.in"
+run "$HEXCALC" < "$TMP.in"
+expect "U: more than 255 entries" 0 "^-> 00000000  wd(8)  idx$"
+expect "U: undo beyond the first entry" 0 "no more undo history"
+
+# with a budget of 1 KiB, fewer than 300 256-bit entries are kept
+{
+    printf '%s\n' "U 1000 1" "w 64"
+    awk 'BEGIN { for(i = 0; i < 300; i++) printf "i %d\n", i % 256 }'
+    printf '%s\n' U H q
+} > "$TMP.in"
+run "$HEXCALC" < "$TMP.in"
+expect "U: capacity and budget" 0 "^hex-calc> 1000 (memory budget 1 KiB, 1 KiB used)$"
+check "U: budget limits the entries" [ "$(grep -c 'wd(64)' "$TMP")" -lt 100 ]
+
+session U "U 0" "U 2 0" "U x"
+expect "U: defaults" 0 "^hex-calc> 14 (memory budget 65536 KiB, 1 KiB used)$"
+expect "U: capacity too small" 0 "history size too small"
+expect "U: budget too small" 0 "history memory budget too small"
+expect "U: not a number" 0 "argument(s) must be positive integer(s)"
+
+# resizing keeps the newest entries
+session 1 2 3 4 5 "U 2" H "U 20" 6 H u u u u
+expect "U: shrinking keeps the newest entries" 0 "^   00000003  wd(8)  idx$"
+expect_not "U: shrinking forgets the oldest entries" "^   00000002  wd(8)"
+expect "U: growing keeps all entries" 0 "^-> 00000006  wd(8)  idx$"
+check "U: entries left after growing" [ "$(grep -c 'no more undo history' "$TMP")" -eq 1 ]
+
+# an entry made after undoing starts a new branch, kept next to the old one
+session 1 2 4 u u 3 H "<" H ">" ">" u ">" r r H
+expect "branch: new branch" 0 "^-> 00000003  wd(8)  idx  branch 2/2$"
+expect "branch: <" 0 "^-> 00000002  wd(8)  idx  branch 1/2$"
+expect "branch: redo follows the branch" 0 "^   00000002  wd(8)  idx  branch 1/2$"
+expect "branch: redo to the end of the branch" 0 "^-> 00000004  wd(8)  idx$"
+expect "branch: no other branch" 0 "no other branch at this step"
+
+session 1 2 u 3 ">" ">" H
+expect "branch: > wraps around" 0 "^-> 00000003  wd(8)  idx  branch 2/2$"
+
+# with the current entry at the root, the newest entries are forgotten first,
+# starting with those redo doesn't reach
+session 1 2 3 4 5 u u u u u "U 2" H r r r
+expect "branch: shrinking keeps the oldest redo entries" 0 "^   00000002  wd(8)  idx$"
+check "branch: shrinking forgets the newest redo entries" \
+      [ "$(grep -c 'no more redo history' "$TMP")" -eq 1 ]
+
+session 1 2 4 u u 3 u u "U 3" H
+expect "branch: shrinking keeps the branch redo follows" 0 "^   00000003  wd(8)  idx  branch 2/2$"
+expect_not "branch: shrinking forgets other branches first" "^   00000002"
+
+rm -rf "$TMP" "$TMP".*
+[ "$failures" -eq 0 ]